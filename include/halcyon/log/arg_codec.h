@@ -0,0 +1,264 @@
+#ifndef HALCYON_LOG_ARG_CODEC_H
+#define HALCYON_LOG_ARG_CODEC_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace halcyon::log {
+
+// Wire type of a captured argument. Producers copy the raw value bytes into
+// the staging ring; the backend uses the call site's list of ArgTypes to walk
+// them back and render text.
+enum class ArgType : uint8_t {
+  kBool,     // 1 byte
+  kChar,     // 1 byte
+  kInt32,    // 4 bytes
+  kUint32,   // 4 bytes
+  kInt64,    // 8 bytes
+  kUint64,   // 8 bytes
+  kDouble,   // 8 bytes
+  kPointer,  // 8 bytes
+  kString,   // uint32_t length followed by the bytes, no terminator
+};
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool kAlwaysFalse = false;
+
+template <typename T>
+constexpr ArgType argTypeOf() {
+  using U = std::decay_t<T>;
+  if constexpr (std::is_same_v<U, bool>) {
+    return ArgType::kBool;
+  } else if constexpr (std::is_same_v<U, char>) {
+    return ArgType::kChar;
+  } else if constexpr (std::is_enum_v<U>) {
+    return argTypeOf<std::underlying_type_t<U>>();
+  } else if constexpr (std::is_integral_v<U>) {
+    if constexpr (sizeof(U) <= sizeof(int32_t)) {
+      return std::is_signed_v<U> ? ArgType::kInt32 : ArgType::kUint32;
+    } else {
+      return std::is_signed_v<U> ? ArgType::kInt64 : ArgType::kUint64;
+    }
+  } else if constexpr (std::is_floating_point_v<U>) {
+    return ArgType::kDouble;
+  } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*> ||
+                       std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>) {
+    return ArgType::kString;
+  } else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>) {
+    return ArgType::kPointer;
+  } else {
+    static_assert(kAlwaysFalse<T>, "halcyon_log: unsupported log argument type");
+  }
+}
+
+template <typename... Args>
+struct ArgTypeList {
+  static constexpr std::array<ArgType, sizeof...(Args)> kTypes{argTypeOf<Args>()...};
+};
+
+// Only used in unevaluated context to turn the macro arguments into types.
+template <typename... Args>
+ArgTypeList<std::decay_t<Args>...> argTypeList(const Args&...);
+
+template <typename T>
+inline constexpr bool kIsStringArg = argTypeOf<T>() == ArgType::kString;
+
+template <typename... Args>
+inline constexpr size_t kNumStringArgs = (size_t{0} + ... + (kIsStringArg<Args> ? 1 : 0));
+
+template <typename T>
+std::string_view stringArg(const T& v) {
+  using U = std::decay_t<T>;
+  if constexpr (std::is_array_v<T>) {
+    return std::string_view(v);
+  } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+    return v ? std::string_view(v) : std::string_view("(null)");
+  } else {
+    return std::string_view(v);
+  }
+}
+
+// Wire size of a fixed-size argument.
+template <typename T>
+constexpr size_t fixedArgSize() {
+  switch (argTypeOf<T>()) {
+    case ArgType::kBool:
+    case ArgType::kChar:
+      return 1;
+    case ArgType::kInt32:
+    case ArgType::kUint32:
+      return 4;
+    default:
+      return 8;
+  }
+}
+
+template <typename T>
+char* encodeFixedArg(char* p, const T& v) {
+  using U = std::decay_t<T>;
+  constexpr ArgType type = argTypeOf<U>();
+  if constexpr (type == ArgType::kBool || type == ArgType::kChar) {
+    *p = static_cast<char>(v);
+    return p + 1;
+  } else if constexpr (type == ArgType::kPointer) {
+    uint64_t value = reinterpret_cast<uintptr_t>(static_cast<const void*>(v));
+    std::memcpy(p, &value, sizeof(value));
+    return p + sizeof(value);
+  } else {
+    using Stored = std::conditional_t<
+        type == ArgType::kInt32, int32_t,
+        std::conditional_t<type == ArgType::kUint32, uint32_t,
+                           std::conditional_t<type == ArgType::kInt64, int64_t,
+                                              std::conditional_t<type == ArgType::kUint64,
+                                                                 uint64_t, double>>>>;
+    Stored value = static_cast<Stored>(v);
+    std::memcpy(p, &value, sizeof(value));
+    return p + sizeof(value);
+  }
+}
+
+// Measures and encodes one statement's arguments. String lengths are
+// computed once in size() and reused by encode().
+template <typename... Args>
+class ArgEncoder {
+ public:
+  // Bytes needed for the encoded arguments.
+  size_t size(const Args&... args) {
+    size_t total = 0;
+    [[maybe_unused]] size_t index = 0;
+    ((total += measure(args, index)), ...);
+    return total;
+  }
+
+  // Shortens string arguments so that the encoded arguments fit in
+  // `budget` bytes and returns the new encoded size. Fixed-size arguments are
+  // always kept whole.
+  size_t truncate(size_t budget) {
+    size_t total =
+        (size_t{0} + ... + (kIsStringArg<Args> ? sizeof(uint32_t) : fixedArgSize<Args>()));
+    if constexpr (kNumStrings != 0) {
+      size_t perString = budget > total ? (budget - total) / kNumStrings : 0;
+      for (size_t& length : lengths_) {
+        if (length > perString) {
+          length = perString;
+        }
+        total += length;
+      }
+    }
+    return total;
+  }
+
+  // Writes the arguments at `p` and returns the end of the encoded bytes.
+  char* encode(char* p, const Args&... args) {
+    [[maybe_unused]] size_t index = 0;
+    ((p = encodeOne(p, args, index)), ...);
+    return p;
+  }
+
+ private:
+  static constexpr size_t kNumStrings = kNumStringArgs<Args...>;
+
+  template <typename T>
+  size_t measure(const T& v, size_t& index) {
+    if constexpr (kIsStringArg<T>) {
+      size_t length = stringArg(v).size();
+      lengths_[index++] = length;
+      return sizeof(uint32_t) + length;
+    } else {
+      return fixedArgSize<T>();
+    }
+  }
+
+  template <typename T>
+  char* encodeOne(char* p, const T& v, size_t& index) {
+    if constexpr (kIsStringArg<T>) {
+      uint32_t length = static_cast<uint32_t>(lengths_[index++]);
+      std::memcpy(p, &length, sizeof(length));
+      std::memcpy(p + sizeof(length), stringArg(v).data(), length);
+      return p + sizeof(length) + length;
+    } else {
+      return encodeFixedArg(p, v);
+    }
+  }
+
+  size_t lengths_[kNumStrings == 0 ? 1 : kNumStrings];
+};
+
+}  // namespace detail
+
+// Backend side: walks the encoded arguments of one record.
+class ArgReader {
+ public:
+  explicit ArgReader(std::string_view bytes) : p_(bytes.data()), end_(bytes.data() + bytes.size()) {}
+
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, p_, sizeof(T));
+    p_ += sizeof(T);
+    return value;
+  }
+
+  std::string_view readString() {
+    uint32_t length = read<uint32_t>();
+    std::string_view s(p_, length);
+    p_ += length;
+    return s;
+  }
+
+  bool done() const { return p_ >= end_; }
+
+ private:
+  const char* p_;
+  const char* end_;
+};
+
+// Whether `bytes` holds exactly one encoded argument of each of `types`.
+// Records from the staging rings always do; input that is not trusted, such
+// as a binary log file, is checked before an ArgReader walks it.
+inline bool argsMatch(const ArgType* types, uint32_t count, std::string_view bytes) {
+  size_t left = bytes.size();
+  const char* p = bytes.data();
+  for (uint32_t i = 0; i < count; ++i) {
+    size_t size;
+    switch (types[i]) {
+      case ArgType::kBool:
+      case ArgType::kChar:
+        size = 1;
+        break;
+      case ArgType::kInt32:
+      case ArgType::kUint32:
+        size = 4;
+        break;
+      case ArgType::kString: {
+        uint32_t length;
+        if (left < sizeof(length)) {
+          return false;
+        }
+        std::memcpy(&length, p, sizeof(length));
+        size = sizeof(length) + length;
+        break;
+      }
+      default:
+        size = 8;
+        break;
+    }
+    if (size > left) {
+      return false;
+    }
+    p += size;
+    left -= size;
+  }
+  return left == 0;
+}
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_ARG_CODEC_H
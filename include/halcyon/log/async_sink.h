@@ -0,0 +1,81 @@
+#ifndef HALCYON_LOG_ASYNC_SINK_H
+#define HALCYON_LOG_ASYNC_SINK_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "halcyon/log/sink.h"
+
+namespace halcyon::log {
+
+// Runs a text sink on a thread of its own, so that a sink that blocks, such
+// as a console on a stalled terminal or a full pipe, holds up only itself
+// and not the backend and the other sinks. The backend appends lines to an
+// in-memory buffer and moves on; the thread hands them to the wrapped sink
+// several lines per write(). Once the sink is `capacity` bytes behind,
+// further lines are dropped and counted rather than waited for.
+//
+// The level and layout are those of the wrapped sink; setting them on either
+// sets both. flush(), and with it Backend::flush(), stop() and
+// LOG_FATAL, waits at most `flushTimeout` for the wrapped sink; lines still
+// pending then are dropped and counted. While that flush has not completed,
+// later ones do not wait at all.
+class AsyncSink : public Sink {
+ public:
+  static constexpr size_t kDefaultCapacity = 4 * 1024 * 1024;
+  static constexpr std::chrono::milliseconds kDefaultFlushTimeout{1000};
+
+  // Throws std::invalid_argument if `sink` does not want text.
+  explicit AsyncSink(std::shared_ptr<Sink> sink, size_t capacity = kDefaultCapacity,
+                     std::chrono::milliseconds flushTimeout = kDefaultFlushTimeout);
+  ~AsyncSink() override;
+
+  AsyncSink(const AsyncSink&) = delete;
+  AsyncSink& operator=(const AsyncSink&) = delete;
+
+  void setLevel(Level level) override { sink_->setLevel(level); }
+  Level level() const override { return sink_->level(); }
+  void setLayout(Layout layout) override { sink_->setLayout(layout); }
+  std::optional<Layout> layout() const override { return sink_->layout(); }
+
+  void write(std::string_view line) override;
+  void flush() override;
+  void flushAsync() override;
+
+  // Lines dropped because the wrapped sink was too far behind or did not
+  // flush in time.
+  uint64_t droppedLines() const { return droppedLines_.load(std::memory_order_relaxed); }
+
+ private:
+  void run();
+  // Drops the pending lines, counting them. Requires mutex_.
+  void dropPending();
+
+  const std::shared_ptr<Sink> sink_;
+  const size_t capacity_;
+  const std::chrono::milliseconds flushTimeout_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable flushed_;
+  std::string pending_;
+  uint64_t flushRequested_ = 0;
+  uint64_t flushCompleted_ = 0;
+  // The flush that last timed out.
+  uint64_t flushAbandoned_ = 0;
+  bool stopping_ = false;
+  std::atomic<uint64_t> droppedLines_{0};
+  std::thread thread_;
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_ASYNC_SINK_H
@@ -0,0 +1,181 @@
+#ifndef HALCYON_LOG_BACKEND_H
+#define HALCYON_LOG_BACKEND_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "halcyon/log/clock.h"
+#include "halcyon/log/formatter.h"
+#include "halcyon/log/rate_limit.h"
+#include "halcyon/log/sink.h"
+#include "halcyon/log/stats.h"
+#include "halcyon/log/thread_context.h"
+
+namespace halcyon::log {
+
+struct BackendOptions {
+  // Size in bytes of each producer thread's staging ring; rounded up to a
+  // power of two.
+  size_t ringCapacity = 256 * 1024;
+  // How long the backend sleeps when it finds every ring empty.
+  std::chrono::microseconds idleSleep{200};
+  // Upper bound on how long a formatted line may sit in a sink buffer.
+  std::chrono::milliseconds flushInterval{1000};
+  // Where producers take timestamps from. The TSC is much cheaper to read
+  // than clock_gettime; the backend converts ticks to wall-clock time.
+  ClockSource clockSource = ClockSource::kAuto;
+  // How often the backend refines the TSC calibration.
+  std::chrono::milliseconds calibrationInterval{1000};
+  // How often the backend logs a WARN line counting the records producers
+  // dropped since the last one (see OverflowPolicy), and an INFO line per
+  // rate-limited statement counting the records its limiter suppressed.
+  // Nothing is logged when there is nothing to count.
+  std::chrono::milliseconds dropReportInterval{1000};
+  // Also time every log statement and the formatting of every record (see
+  // LogStats). Costs two timestamp reads per record on each side.
+  bool timingStats = false;
+  // How often the backend logs an INFO line with its statistics; zero turns
+  // it off.
+  std::chrono::milliseconds statsInterval{0};
+  // Collapse runs of identical records, that is records of the same call
+  // site with the same arguments, into the first one followed by a "last
+  // message repeated N times" line at the same level. A run still going is
+  // summarized at every sink flush.
+  bool collapseDuplicates = false;
+  // How text sinks render records unless they set a layout of their own:
+  // the plain text line, JSON Lines or logfmt (see Layout).
+  Layout layout = Layout::kText;
+  // Runs one backend thread per NUMA node instead of a single one, for hosts
+  // where draining every ring from one socket is the bottleneck. Each
+  // thread is pinned to its node's CPUs and drains the rings of the threads
+  // that started logging on that node, which are allocated there, into
+  // sinks of its own: those this function returns for the node, typically
+  // a file per node. Sinks added with addSink() and the backend's own lines
+  // go with the first node. Where there is only one node, or the topology
+  // is unknown, a single thread writes to both.
+  std::function<std::vector<std::shared_ptr<Sink>>(int node)> numaSinks;
+};
+
+// Drains the per-thread staging rings on a dedicated thread, or one per NUMA
+// node (BackendOptions::numaSinks). Producers only copy a record into their
+// own ring; all formatting and I/O happens here.
+class Backend {
+ public:
+  static Backend& instance();
+
+  // Applies the options and starts the backend thread. Calling start() again
+  // is a no-op. The backend starts itself with default options the first
+  // time any thread logs.
+  void start(const BackendOptions& options = {});
+  void ensureStarted() { start(options_); }
+
+  // Drains everything that was logged, flushes the sinks and joins the
+  // backend threads.
+  void stop();
+
+  // Sinks must be added before the backend starts, either through start()
+  // or implicitly by the first log statement; throws std::logic_error
+  // otherwise. If none were added, records go to stdout. Each record goes to
+  // every sink whose level it meets, formatted once per layout; wrap sinks
+  // that may block in an AsyncSink.
+  void addSink(std::shared_ptr<Sink> sink);
+
+  // Blocks until every record logged before the call has been written and
+  // the sinks have been flushed.
+  void flush();
+
+  // The logger's own metrics. Lock-free: the producer side figures are
+  // gathered by the backend every 100 ms and on flush(), the rest is live.
+  LogStats stats() const;
+
+ private:
+  // What one backend thread owns: the rings it drains, the sinks it writes
+  // to and its share of the statistics. Only the thread touches it, apart
+  // from the atomics and histograms read by stats() and flush().
+  struct Shard {
+    // The node whose rings it drains, or ThreadContext::kAnyNode, and the
+    // CPUs it runs on (any if empty).
+    int node = ThreadContext::kAnyNode;
+    std::vector<int> cpus;
+    std::vector<std::shared_ptr<Sink>> sinks;
+    // The layout of each text sink, resolved at start.
+    std::vector<Layout> sinkLayouts;
+    std::thread thread;
+
+    std::vector<std::shared_ptr<ThreadContext>> contexts;
+    uint64_t contextsVersion = 0;
+    bool reclaimPending = false;
+
+    TimestampConverter clock;
+    // A formatter and the current record's line per layout. The lines grow
+    // on the shard's own thread, so on its node.
+    std::array<Formatter, kNumLayouts> formatters;
+    std::array<std::string, kNumLayouts> lines;
+    // Records were written since the last flush of either kind / since the
+    // last flush that waited for the sinks.
+    bool dirty = false;
+    bool unflushed = false;
+
+    // The record the current run of duplicates repeats, by call site and a
+    // hash of its argument bytes, and the length of the run so far.
+    uint32_t lastSiteId = 0;
+    uint64_t lastArgsHash = 0;
+    Level lastLevel = Level::kInfo;
+    uint64_t repeats = 0;
+    int64_t lastRepeat = 0;
+
+    // Written by the shard's thread only, read by stats().
+    std::atomic<uint64_t> records{0};
+    LatencyHistogram formatTime;
+    LatencyHistogram flushLatency;
+    std::atomic<uint64_t> flushCompleted{0};
+  };
+
+  Backend();
+  ~Backend();
+
+  // The first shard also reports drops, suppressions and statistics.
+  bool isPrimary(const Shard& shard) const { return &shard == shards_.front().get(); }
+
+  void run(Shard& shard);
+  size_t drainAll(Shard& shard);
+  size_t drain(Shard& shard, ThreadContext& context);
+  void dispatch(Shard& shard, const Record& record);
+  bool collapse(Shard& shard, const Record& record);
+  void reportRepeats(Shard& shard);
+  void reportDrops();
+  void reportSuppressed();
+  void publishStats();
+  void reportStats();
+  // Writes one of the backend's own records to the first shard's sinks.
+  void report(const Record& record);
+  void flushSinks(Shard& shard, bool wait);
+
+  std::once_flag startOnce_;
+  BackendOptions options_;
+  // Sinks given to addSink(), for the first shard.
+  std::vector<std::shared_ptr<Sink>> sinks_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<bool> running_{false};
+
+  std::array<uint64_t, kNumLevels> reportedDrops_{};
+
+  // Producer side figures as of the last publishStats().
+  std::array<std::atomic<uint64_t>, kNumLevels> dropped_{};
+  std::atomic<size_t> queueHighWater_{0};
+  LatencyHistogram enqueueLatency_;
+
+  std::atomic<uint64_t> flushRequested_{0};
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_BACKEND_H
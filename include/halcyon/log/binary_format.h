@@ -0,0 +1,132 @@
+#ifndef HALCYON_LOG_BINARY_FORMAT_H
+#define HALCYON_LOG_BINARY_FORMAT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "halcyon/log/call_site.h"
+#include "halcyon/log/record.h"
+
+// Compact binary log files.
+//
+// A file is a header followed by a sequence of frames:
+//
+//   header  "HLOGBIN1"  version:u8  baseTimestamp:varint  siteCount:varint
+//           site definitions of every call site registered when the file was
+//           opened
+//   frame   kSiteFrame  site definition, for a call site first seen later
+//           kRecordFrame  siteId:varint  timestampDelta:zigzag  threadId:varint
+//                         arguments
+//
+//   site definition  id:varint  line:varint  level:u8  argCount:varint
+//                    argTypes:u8[argCount]  file  function  format
+//                    (strings are length:varint followed by the bytes;
+//                    the top bit of level marks a LOGKV_* site)
+//
+// Timestamps are nanoseconds since the Unix epoch, delta-encoded against the
+// previous record (the first against the header's base). Integer arguments
+// are varints (zigzag for signed types), doubles are their 8 raw bytes,
+// strings are length-prefixed. The argument types come from the site
+// definition, so records carry no per-argument tags.
+namespace halcyon::log::binary {
+
+inline constexpr char kMagic[8] = {'H', 'L', 'O', 'G', 'B', 'I', 'N', '1'};
+inline constexpr uint8_t kVersion = 1;
+
+// Set in a site definition's level byte for a structured call site.
+inline constexpr uint8_t kStructuredFlag = 0x80;
+
+enum FrameType : uint8_t {
+  kSiteFrame = 1,
+  kRecordFrame = 2,
+};
+
+inline uint64_t zigzagEncode(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline void putVarint(std::string& out, uint64_t v) {
+  char buf[10];
+  size_t n = 0;
+  while (v >= 0x80) {
+    buf[n++] = static_cast<char>(v | 0x80);
+    v >>= 7;
+  }
+  buf[n++] = static_cast<char>(v);
+  out.append(buf, n);
+}
+
+// Returns false on truncated or overlong input.
+inline bool getVarint(const char*& p, const char* end, uint64_t& v) {
+  v = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(*p++);
+    v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Turns records into binary frames. Used on the backend thread only.
+class Encoder {
+ public:
+  // Appends the file header, including the definitions of every call site
+  // registered so far.
+  void writeHeader(std::string& out, int64_t baseTimestamp);
+
+  // Appends a record frame, preceded by a site frame if the record's call
+  // site has not been written to this file yet.
+  void writeRecord(std::string& out, const Record& record);
+
+ private:
+  void writeSite(std::string& out, uint32_t id, const CallSite& site);
+
+  std::vector<bool> writtenSites_;
+  int64_t lastTimestamp_ = 0;
+};
+
+// Reads a binary log back into records that the text Formatter can render.
+class Decoder {
+ public:
+  enum class Status { kRecord, kEnd, kError };
+
+  // `data` must stay valid while records are being read.
+  explicit Decoder(std::string_view data);
+  ~Decoder();
+
+  // False if the data does not start with a valid header.
+  bool readHeader();
+
+  // Decodes the next record. The record's `args` and `site` stay valid until
+  // the next call.
+  Status next(Record& record);
+
+  const std::string& error() const { return error_; }
+
+ private:
+  struct Site;
+
+  bool readSite();
+  bool readString(std::string& s);
+  Status fail(const char* what);
+
+  const char* p_;
+  const char* end_;
+  int64_t lastTimestamp_ = 0;
+  std::vector<std::unique_ptr<Site>> sites_;
+  std::string args_;
+  std::string error_;
+};
+
+}  // namespace halcyon::log::binary
+
+#endif  // HALCYON_LOG_BINARY_FORMAT_H
@@ -0,0 +1,107 @@
+#ifndef HALCYON_LOG_CALL_SITE_H
+#define HALCYON_LOG_CALL_SITE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "halcyon/log/arg_codec.h"
+#include "halcyon/log/format_string.h"
+#include "halcyon/log/level.h"
+#include "halcyon/log/platform.h"
+
+namespace halcyon::log {
+
+// Everything about a log statement that is known at compile time, including
+// its format string already split into segments. Each statement owns one as
+// a constant-initialized function-local static and registers it with the
+// CallSiteRegistry the first time it runs; records then carry only the
+// 32-bit id.
+struct CallSite {
+  constexpr CallSite(const char* file, const char* function, uint32_t line, Level level,
+                     const char* format, const FormatSegment* segments, uint32_t segmentCount,
+                     const ArgType* argTypes, uint32_t argCount, bool structured = false)
+      : file(file),
+        function(function),
+        line(line),
+        level(level),
+        format(format),
+        segments(segments),
+        segmentCount(segmentCount),
+        argTypes(argTypes),
+        argCount(argCount),
+        structured(structured) {}
+
+  CallSite(const CallSite&) = delete;
+  CallSite& operator=(const CallSite&) = delete;
+
+  // Registry id, assigned on first use. Never 0 once assigned.
+  uint32_t id() {
+    uint32_t id = id_.load(std::memory_order_acquire);
+    return HALCYON_LOG_LIKELY(id != 0) ? id : registerSelf();
+  }
+
+  const char* const file;
+  const char* const function;
+  const uint32_t line;
+  const Level level;
+  const char* const format;
+  const FormatSegment* const segments;
+  const uint32_t segmentCount;
+  const ArgType* const argTypes;
+  const uint32_t argCount;
+  // A LOGKV_* statement: `format` is a message without placeholders and the
+  // arguments are key/value pairs, each key captured as a string.
+  const bool structured;
+
+ private:
+  friend class CallSiteRegistry;
+
+  HALCYON_LOG_NOINLINE uint32_t registerSelf();
+
+  std::atomic<uint32_t> id_{0};
+};
+
+// Append-only table of every call site that has executed, indexed by id.
+// Registration takes a lock once per call site; lookups are lock-free so the
+// backend can resolve ids without contending with producers.
+class CallSiteRegistry {
+ public:
+  static constexpr uint32_t kChunkSize = 1024;
+  static constexpr uint32_t kMaxChunks = 4096;
+
+  static CallSiteRegistry& instance();
+
+  // Returns the site's id, assigning one if it has none yet.
+  uint32_t add(CallSite& site);
+
+  // Returns nullptr for ids that were never assigned.
+  const CallSite* find(uint32_t id) const {
+    uint32_t index = id - 1;
+    if (index >= kChunkSize * kMaxChunks) {
+      return nullptr;
+    }
+    const Chunk* chunk = chunks_[index / kChunkSize].load(std::memory_order_acquire);
+    return chunk ? chunk->sites[index % kChunkSize].load(std::memory_order_acquire) : nullptr;
+  }
+
+  // Number of registered sites; ids run from 1 to size().
+  uint32_t size() const { return size_.load(std::memory_order_acquire); }
+
+ private:
+  struct Chunk {
+    std::atomic<const CallSite*> sites[kChunkSize] = {};
+  };
+
+  CallSiteRegistry() = default;
+  ~CallSiteRegistry();
+
+  std::mutex mutex_;
+  std::atomic<Chunk*> chunks_[kMaxChunks] = {};
+  std::atomic<uint32_t> size_{0};
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_CALL_SITE_H
@@ -0,0 +1,103 @@
+#ifndef HALCYON_LOG_CLOCK_H
+#define HALCYON_LOG_CLOCK_H
+
+#include <time.h>
+
+#include <cstdint>
+
+#include "halcyon/log/platform.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HALCYON_LOG_HAS_TSC 1
+#else
+#define HALCYON_LOG_HAS_TSC 0
+#endif
+
+namespace halcyon::log {
+
+enum class ClockSource : uint8_t {
+  kAuto,    // TSC when the CPU has an invariant one, otherwise kSystem
+  kTsc,     // rdtsc; falls back to kSystem if the TSC is not invariant
+  kSystem,  // clock_gettime(CLOCK_REALTIME)
+};
+
+namespace detail {
+
+// Resolved source; written once by the backend before any thread can log.
+extern ClockSource gClockSource;
+
+inline uint64_t systemNanoseconds() {
+  struct timespec ts;
+  ::clock_gettime(CLOCK_REALTIME, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+}  // namespace detail
+
+// Raw timestamp taken by producers: TSC ticks or wall-clock nanoseconds,
+// depending on the resolved source. The backend converts it with a
+// TimestampConverter when it formats the record.
+inline uint64_t rawTimestamp() {
+#if HALCYON_LOG_HAS_TSC
+  if (HALCYON_LOG_LIKELY(detail::gClockSource == ClockSource::kTsc)) {
+    return __rdtsc();
+  }
+#endif
+  return detail::systemNanoseconds();
+}
+
+// True if the CPU advertises an invariant TSC (constant rate across P- and
+// C-states and synchronized between cores).
+bool hasInvariantTsc();
+
+// Converts raw timestamps to nanoseconds since the Unix epoch. Owned by the
+// backend thread.
+//
+// For the TSC the tick rate is measured against CLOCK_MONOTONIC_RAW over an
+// ever longer window, so it keeps getting more precise, while the offset is
+// re-anchored to CLOCK_REALTIME on each recalibration so that wall-clock
+// adjustments show up in the output.
+class TimestampConverter {
+ public:
+  // Resolves `source` and publishes it to producers. Must run before any
+  // thread logs.
+  static ClockSource select(ClockSource source);
+
+  // Takes the initial measurement. Blocks the calling thread for about
+  // `window` nanoseconds when the source is the TSC.
+  void calibrate(uint64_t windowNs = 10000000);
+
+  // Refines the tick rate and re-anchors the offset; cheap, meant to be
+  // called periodically.
+  void recalibrate();
+
+  int64_t toNanoseconds(uint64_t raw) const {
+    if (!tsc_) {
+      return static_cast<int64_t>(raw);
+    }
+    int64_t ticks = static_cast<int64_t>(raw - baseTicks_);
+    return baseNs_ + static_cast<int64_t>(static_cast<double>(ticks) * nsPerTick_);
+  }
+
+  double nsPerTick() const { return nsPerTick_; }
+
+ private:
+  struct Sample {
+    uint64_t ticks;
+    int64_t monotonicNs;
+    int64_t realtimeNs;
+  };
+
+  static Sample sample();
+
+  bool tsc_ = false;
+  Sample first_{};
+  uint64_t baseTicks_ = 0;
+  int64_t baseNs_ = 0;
+  double nsPerTick_ = 1.0;
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_CLOCK_H
@@ -0,0 +1,26 @@
+#ifndef HALCYON_LOG_ESCAPE_H
+#define HALCYON_LOG_ESCAPE_H
+
+#include <string>
+#include <string_view>
+
+// Quoting for the structured layouts. Log text is nearly always clean, so
+// the scan for characters that need escaping goes 16 or 32 bytes at a time
+// and clean runs are appended in one piece.
+
+namespace halcyon::log::detail {
+
+// Appends `s` as the contents of a JSON string, without the quotes.
+void appendJsonEscaped(std::string& out, std::string_view s);
+
+// Appends `s` as a logfmt value: bare if it can be, otherwise quoted and
+// escaped as a JSON string.
+void appendLogfmtValue(std::string& out, std::string_view s);
+
+// Appends `s` as a logfmt key, with characters a key cannot hold replaced
+// by '_'.
+void appendLogfmtKey(std::string& out, std::string_view s);
+
+}  // namespace halcyon::log::detail
+
+#endif  // HALCYON_LOG_ESCAPE_H
@@ -0,0 +1,57 @@
+#ifndef HALCYON_LOG_FILE_ARCHIVER_H
+#define HALCYON_LOG_FILE_ARCHIVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace halcyon::log {
+
+// Housekeeping of the files a FileSink rotated away. Rotated files are named
+// `<path>.YYYYmmdd-HHMMSS[.N][.gz]`. A sweep gzips the uncompressed ones and
+// deletes those beyond the retention limits, on a thread running at the
+// lowest CPU and idle I/O priority so that it never competes with the
+// application or the backend.
+class FileArchiver {
+ public:
+  // `maxFiles` and `maxAge` of zero mean unlimited.
+  FileArchiver(const std::string& path, bool compress, size_t maxFiles,
+               std::chrono::seconds maxAge);
+  // Abandons a compression in progress; the file is picked up again by the
+  // next sweep, in this process or the next one.
+  ~FileArchiver();
+
+  FileArchiver(const FileArchiver&) = delete;
+  FileArchiver& operator=(const FileArchiver&) = delete;
+
+  // Asks for a sweep; returns immediately.
+  void sweep();
+
+  // Picks the name a file rotated at `now` is renamed to.
+  static std::string rotatedName(const std::string& path,
+                                 std::chrono::system_clock::time_point now);
+
+ private:
+  void run();
+  void sweepOnce();
+  bool compressFile(const std::string& source);
+
+  const std::string path_;
+  const bool compress_;
+  const size_t maxFiles_;
+  const std::chrono::seconds maxAge_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool sweepRequested_ = true;
+  std::atomic<bool> stopping_{false};
+  std::thread thread_;
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_FILE_ARCHIVER_H
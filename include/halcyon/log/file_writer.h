@@ -0,0 +1,105 @@
+#ifndef HALCYON_LOG_FILE_WRITER_H
+#define HALCYON_LOG_FILE_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "halcyon/log/file_archiver.h"
+
+namespace halcyon::log {
+
+struct FileSinkOptions {
+  // Size of each buffer. A buffer is handed to the flusher as soon as it is
+  // full, so this is also the size-based flush trigger.
+  size_t bufferSize = 1024 * 1024;
+  // Buffers allowed to exist at once. When all of them are waiting to be
+  // written the backend blocks until the flusher frees one.
+  size_t maxBuffers = 4;
+  // Time-based flush trigger: the flusher takes a partially filled buffer
+  // when it has had nothing to write for this long.
+  std::chrono::milliseconds flushInterval{1000};
+
+  // Rotation (text FileSink only). The file is renamed to
+  // `<path>.YYYYmmdd-HHMMSS` and a new one started once it reaches
+  // maxFileSize bytes, or when local time crosses a multiple of
+  // rotateInterval (one day rotates at midnight). Zero disables a trigger.
+  uint64_t maxFileSize = 0;
+  std::chrono::seconds rotateInterval{0};
+  // Retention of rotated files; zero keeps them all.
+  size_t maxFiles = 0;
+  std::chrono::seconds maxAge{0};
+  // Gzip rotated files on a low-priority background thread.
+  bool compress = false;
+};
+
+// Double-buffered file writer shared by the file sinks. The backend thread
+// appends into the front buffer; full buffers are queued for a flusher
+// thread, which writes everything queued with a single writev(). The lock
+// taken per append is uncontended except at a hand-over. Rotation happens on
+// the flusher thread between writes, so it never stalls the backend.
+class FileWriter {
+ public:
+  // Opens `path` with open(2) `flags`; O_WRONLY, O_CREAT and O_CLOEXEC are
+  // added. Throws std::system_error if the file cannot be opened.
+  FileWriter(const std::string& path, int flags, const FileSinkOptions& options);
+  // Writes what is still buffered and joins the flusher.
+  ~FileWriter();
+
+  FileWriter(const FileWriter&) = delete;
+  FileWriter& operator=(const FileWriter&) = delete;
+
+  // Backend thread only.
+  void append(const char* data, size_t size);
+
+  // Blocks until everything appended so far has been written to the file.
+  void flush();
+  // Queues the partially filled front buffer for the flusher.
+  void flushAsync();
+
+ private:
+  struct Buffer {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+  };
+
+  void handOff(std::unique_lock<std::mutex>& lock);
+  void takeSpare();
+  void run();
+  void writeBatch(const std::vector<Buffer>& batch);
+  void maybeRotate();
+  std::chrono::system_clock::time_point nextRotation(
+      std::chrono::system_clock::time_point now) const;
+
+  const FileSinkOptions options_;
+  const std::string path_;
+  const int flags_;
+  // Owned by the flusher thread.
+  int fd_;
+  uint64_t fileSize_ = 0;
+  std::chrono::system_clock::time_point nextRotation_;
+  std::unique_ptr<FileArchiver> archiver_;
+
+  std::mutex mutex_;
+  std::condition_variable wakeFlusher_;
+  std::condition_variable batchWritten_;
+  Buffer current_;
+  std::vector<Buffer> full_;
+  std::vector<Buffer> spare_;
+  size_t allocated_ = 0;
+  uint64_t handedOff_ = 0;
+  uint64_t written_ = 0;
+  bool stopping_ = false;
+  int lastError_ = 0;
+  std::thread thread_;
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_FILE_WRITER_H
@@ -0,0 +1,244 @@
+#ifndef HALCYON_LOG_FORMAT_STRING_H
+#define HALCYON_LOG_FORMAT_STRING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "halcyon/log/arg_codec.h"
+
+namespace halcyon::log {
+
+// Replacement field options: `{:[<|>][+][0][width][.precision][type]}`.
+//
+//   type  d x X o b   integers (and char)
+//         f e g       floating point
+//         s           strings and bools
+//         c           char and integers
+//         p           pointers
+struct FormatSpec {
+  enum Align : uint8_t { kAlignDefault, kAlignLeft, kAlignRight };
+
+  char type = 0;  // 0 when omitted
+  Align align = kAlignDefault;
+  bool plus = false;
+  bool zeroPad = false;
+  uint16_t width = 0;
+  int16_t precision = -1;  // -1 when omitted
+};
+
+// A literal run of the format string followed by at most one argument.
+// Escaped braces split the literal, which is why a format string can have
+// more segments than arguments.
+struct FormatSegment {
+  uint16_t literalOffset = 0;
+  uint16_t literalLength = 0;
+  bool hasArg = false;
+  FormatSpec spec;
+};
+
+enum class FormatError : uint8_t {
+  kNone,
+  kUnmatchedOpenBrace,
+  kUnmatchedCloseBrace,
+  kInvalidSpec,
+  kTooLong,
+};
+
+namespace detail {
+
+inline constexpr unsigned kMaxWidth = 1024;
+inline constexpr unsigned kMaxPrecision = 100;
+
+// Walks `fmt` and calls emit(const FormatSegment&) for each segment. Usable
+// both in constant evaluation, where the macros bake the result into the call
+// site, and at run time, where offline tools re-parse stored format strings.
+template <typename Emit>
+constexpr FormatError parseFormat(std::string_view fmt, Emit&& emit) {
+  if (fmt.size() > UINT16_MAX) {
+    return FormatError::kTooLong;
+  }
+  size_t literal = 0;
+  size_t i = 0;
+  auto segment = [&](size_t end) {
+    FormatSegment seg;
+    seg.literalOffset = static_cast<uint16_t>(literal);
+    seg.literalLength = static_cast<uint16_t>(end - literal);
+    return seg;
+  };
+  while (i < fmt.size()) {
+    char c = fmt[i];
+    if (c == '}') {
+      if (i + 1 >= fmt.size() || fmt[i + 1] != '}') {
+        return FormatError::kUnmatchedCloseBrace;
+      }
+      emit(segment(i + 1));
+      i += 2;
+      literal = i;
+    } else if (c == '{') {
+      if (i + 1 < fmt.size() && fmt[i + 1] == '{') {
+        emit(segment(i + 1));
+        i += 2;
+        literal = i;
+        continue;
+      }
+      FormatSegment seg = segment(i);
+      seg.hasArg = true;
+      ++i;
+      if (i < fmt.size() && fmt[i] == ':') {
+        ++i;
+        FormatSpec& spec = seg.spec;
+        if (i < fmt.size() && (fmt[i] == '<' || fmt[i] == '>')) {
+          spec.align = fmt[i] == '<' ? FormatSpec::kAlignLeft : FormatSpec::kAlignRight;
+          ++i;
+        }
+        if (i < fmt.size() && fmt[i] == '+') {
+          spec.plus = true;
+          ++i;
+        }
+        if (i < fmt.size() && fmt[i] == '0') {
+          spec.zeroPad = true;
+          ++i;
+        }
+        unsigned width = 0;
+        while (i < fmt.size() && fmt[i] >= '0' && fmt[i] <= '9') {
+          width = width * 10 + static_cast<unsigned>(fmt[i++] - '0');
+          if (width > kMaxWidth) {
+            return FormatError::kInvalidSpec;
+          }
+        }
+        spec.width = static_cast<uint16_t>(width);
+        if (i < fmt.size() && fmt[i] == '.') {
+          ++i;
+          unsigned precision = 0;
+          bool digits = false;
+          while (i < fmt.size() && fmt[i] >= '0' && fmt[i] <= '9') {
+            precision = precision * 10 + static_cast<unsigned>(fmt[i++] - '0');
+            digits = true;
+            if (precision > kMaxPrecision) {
+              return FormatError::kInvalidSpec;
+            }
+          }
+          if (!digits) {
+            return FormatError::kInvalidSpec;
+          }
+          spec.precision = static_cast<int16_t>(precision);
+        }
+        if (i < fmt.size() && fmt[i] != '}') {
+          switch (fmt[i]) {
+            case 'd': case 'x': case 'X': case 'o': case 'b':
+            case 'f': case 'e': case 'g': case 's': case 'c': case 'p':
+              spec.type = fmt[i++];
+              break;
+            default:
+              return FormatError::kInvalidSpec;
+          }
+        }
+      }
+      if (i >= fmt.size()) {
+        return FormatError::kUnmatchedOpenBrace;
+      }
+      if (fmt[i] != '}') {
+        return FormatError::kInvalidSpec;
+      }
+      emit(seg);
+      ++i;
+      literal = i;
+    } else {
+      ++i;
+    }
+  }
+  if (literal < fmt.size()) {
+    emit(segment(fmt.size()));
+  }
+  return FormatError::kNone;
+}
+
+// True if `spec` can render an argument of `type`.
+constexpr bool specAccepts(const FormatSpec& spec, ArgType type) {
+  bool integer = type == ArgType::kInt32 || type == ArgType::kUint32 ||
+                 type == ArgType::kInt64 || type == ArgType::kUint64;
+  if (spec.precision >= 0 && type != ArgType::kDouble && type != ArgType::kString) {
+    return false;
+  }
+  switch (spec.type) {
+    case 0:
+      return true;
+    case 'd': case 'x': case 'X': case 'o': case 'b':
+      return integer || type == ArgType::kChar;
+    case 'f': case 'e': case 'g':
+      return type == ArgType::kDouble;
+    case 's':
+      return type == ArgType::kString || type == ArgType::kBool;
+    case 'c':
+      return integer || type == ArgType::kChar;
+    case 'p':
+      return type == ArgType::kPointer;
+  }
+  return false;
+}
+
+constexpr size_t countSegments(std::string_view fmt) {
+  size_t count = 0;
+  parseFormat(fmt, [&count](const FormatSegment&) { ++count; });
+  return count;
+}
+
+// Deliberately not constexpr: reaching one of these while evaluating
+// compileFormat() turns a malformed format string into a compile error that
+// names the problem.
+void formatErrorUnmatchedOpenBrace();
+void formatErrorUnmatchedCloseBrace();
+void formatErrorInvalidSpec();
+void formatErrorTooLong();
+void formatErrorTooFewArguments();
+void formatErrorTooManyArguments();
+void formatErrorSpecDoesNotMatchArgumentType();
+
+// Parses and validates a format string against the argument types of the
+// statement. N must be countSegments(fmt).
+template <size_t N, typename ArgTypes>
+consteval std::array<FormatSegment, N> compileFormat(std::string_view fmt) {
+  std::array<FormatSegment, N> segments{};
+  size_t count = 0;
+  size_t arg = 0;
+  bool typeMismatch = false;
+  constexpr auto& types = ArgTypes::kTypes;
+  FormatError error = parseFormat(fmt, [&](const FormatSegment& seg) {
+    segments[count++] = seg;
+    if (seg.hasArg) {
+      if (arg < types.size() && !specAccepts(seg.spec, types[arg])) {
+        typeMismatch = true;
+      }
+      ++arg;
+    }
+  });
+  switch (error) {
+    case FormatError::kNone: break;
+    case FormatError::kUnmatchedOpenBrace: formatErrorUnmatchedOpenBrace(); break;
+    case FormatError::kUnmatchedCloseBrace: formatErrorUnmatchedCloseBrace(); break;
+    case FormatError::kInvalidSpec: formatErrorInvalidSpec(); break;
+    case FormatError::kTooLong: formatErrorTooLong(); break;
+  }
+  if (arg > types.size()) {
+    formatErrorTooFewArguments();
+  }
+  if (arg < types.size()) {
+    formatErrorTooManyArguments();
+  }
+  if (typeMismatch) {
+    formatErrorSpecDoesNotMatchArgumentType();
+  }
+  return segments;
+}
+
+// Layout of the `{}` call site shared by all stream statements.
+inline constexpr std::array<FormatSegment, 1> kStreamSegments =
+    compileFormat<1, ArgTypeList<std::string_view>>("{}");
+
+}  // namespace detail
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_FORMAT_STRING_H
@@ -0,0 +1,67 @@
+#ifndef HALCYON_LOG_FORMATTER_H
+#define HALCYON_LOG_FORMATTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "halcyon/log/arg_codec.h"
+#include "halcyon/log/record.h"
+
+namespace halcyon::log {
+
+enum class Layout : uint8_t {
+  // 2026-10-15 22:57:00.123456 INFO  12345 message key=value - file.cpp:42
+  kText,
+  // {"ts":"2026-10-15T22:57:00.123456+08:00","level":"INFO","thread":12345,
+  //  "msg":"message","key":value,"file":"file.cpp","line":42}
+  kJson,
+  // ts=2026-10-15T22:57:00.123456+08:00 level=INFO thread=12345
+  //  msg=message key=value caller=file.cpp:42
+  kLogfmt,
+};
+
+inline constexpr size_t kNumLayouts = 3;
+
+// Renders a record as a line in one of the layouts above; each is a single
+// line per record. The fields of a LOGKV_* statement follow the message.
+//
+// Runs on the backend thread only.
+class Formatter {
+ public:
+  explicit Formatter(Layout layout = Layout::kText) : layout_(layout) {}
+
+  // Appends the rendered line, including the trailing newline, to `out`.
+  void format(const Record& record, std::string& out);
+
+  // Appends only the message: the call site's precompiled format segments
+  // with the captured arguments rendered in between.
+  void formatMessage(const Record& record, std::string& out);
+
+ private:
+  // "YYYY-MM-DD HH:MM:SS."
+  static constexpr size_t kPrefixSize = 20;
+
+  // "+HH:MM"
+  static constexpr size_t kOffsetSize = 6;
+
+  void formatStructured(const Record& record, std::string& out);
+  void appendTimestamp(int64_t timestamp, std::string& out);
+  void appendFields(const Record& record, std::string& out);
+  void appendKey(std::string_view key, std::string& out);
+  void appendValue(ArgReader& reader, ArgType type, std::string& out);
+  void appendString(std::string_view s, std::string& out);
+
+  Layout layout_;
+  int64_t cachedSecond_ = INT64_MIN;
+  char cachedPrefix_[kPrefixSize] = {};
+  // UTC offset of the cached second, for the RFC 3339 timestamps.
+  char cachedOffset_[kOffsetSize] = {};
+  // The message and rendered values, before they are escaped.
+  std::string scratch_;
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_FORMATTER_H
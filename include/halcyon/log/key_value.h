@@ -0,0 +1,52 @@
+#ifndef HALCYON_LOG_KEY_VALUE_H
+#define HALCYON_LOG_KEY_VALUE_H
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+#include "halcyon/log/arg_codec.h"
+
+namespace halcyon::log {
+
+// One field of a structured statement:
+//
+//   LOGKV_INFO("order filled", kv("id", id), kv("px", px));
+//
+// It only refers to the key and the value, so it must not outlive the
+// statement. Values can be of any type LOGF_* accepts.
+template <typename T>
+struct KeyValue {
+  std::string_view key;
+  const T& value;
+};
+
+template <typename T>
+KeyValue<T> kv(std::string_view key, const T& value) {
+  return KeyValue<T>{key, value};
+}
+
+namespace detail {
+
+// Argument types of a structured statement: every field contributes its key,
+// as a string, followed by its value.
+template <typename... Ts>
+struct FieldTypeList {
+  static constexpr std::array<ArgType, 2 * sizeof...(Ts)> kTypes = [] {
+    std::array<ArgType, 2 * sizeof...(Ts)> types{};
+    [[maybe_unused]] size_t i = 0;
+    ((types[i++] = ArgType::kString, types[i++] = argTypeOf<Ts>()), ...);
+    return types;
+  }();
+};
+
+// Only used in unevaluated context; fails to compile unless every argument
+// is a kv().
+template <typename... Ts>
+FieldTypeList<Ts...> fieldTypeList(const KeyValue<Ts>&...);
+
+}  // namespace detail
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_KEY_VALUE_H
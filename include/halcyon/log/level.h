@@ -0,0 +1,56 @@
+#ifndef HALCYON_LOG_LEVEL_H
+#define HALCYON_LOG_LEVEL_H
+
+#include <cstdint>
+#include <string_view>
+
+// Numeric level values for use in preprocessor conditions; they match Level.
+#define HALCYON_LOG_LEVEL_TRACE 0
+#define HALCYON_LOG_LEVEL_DEBUG 1
+#define HALCYON_LOG_LEVEL_INFO 2
+#define HALCYON_LOG_LEVEL_WARN 3
+#define HALCYON_LOG_LEVEL_ERROR 4
+#define HALCYON_LOG_LEVEL_FATAL 5
+#define HALCYON_LOG_LEVEL_OFF 6
+
+// Statements below this level are removed at compile time: their arguments
+// are not evaluated, no call site is registered and no branch remains.
+// Define it before including the logging headers (or on the command line,
+// see the CMake option of the same name).
+#ifndef HALCYON_LOG_ACTIVE_LEVEL
+#define HALCYON_LOG_ACTIVE_LEVEL HALCYON_LOG_LEVEL_TRACE
+#endif
+
+namespace halcyon::log {
+
+enum class Level : uint8_t {
+  kTrace = 0,
+  kDebug,
+  kInfo,
+  kWarn,
+  kError,
+  kFatal,
+  kOff,
+};
+
+inline constexpr int kNumLevels = static_cast<int>(Level::kOff);
+
+inline constexpr Level kActiveLevel = static_cast<Level>(HALCYON_LOG_ACTIVE_LEVEL);
+
+// Fixed-width (5 character) names so that formatted lines stay aligned.
+constexpr std::string_view levelName(Level level) {
+  switch (level) {
+    case Level::kTrace: return "TRACE";
+    case Level::kDebug: return "DEBUG";
+    case Level::kInfo:  return "INFO ";
+    case Level::kWarn:  return "WARN ";
+    case Level::kError: return "ERROR";
+    case Level::kFatal: return "FATAL";
+    case Level::kOff:   return "OFF  ";
+  }
+  return "?????";
+}
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_LEVEL_H
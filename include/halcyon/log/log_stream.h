@@ -0,0 +1,93 @@
+#ifndef HALCYON_LOG_LOG_STREAM_H
+#define HALCYON_LOG_LOG_STREAM_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "halcyon/log/platform.h"
+
+namespace halcyon::log {
+
+// Collects the message body of a `LOG_INFO << ...` statement.
+//
+// The text goes into a fixed buffer inside the stream, which lives on the
+// caller's stack for the duration of the statement, and is copied from
+// there into the thread's staging ring; nothing is allocated. A message
+// that outgrows the inline buffer moves to a heap buffer (grow()), the one
+// slow path. The thread keeps that buffer for its next long message, so
+// only a message longer than any before it allocates.
+class LogStream {
+ public:
+  static constexpr size_t kInlineSize = 1024;
+
+  // Largest spill buffer a thread keeps for reuse.
+  static constexpr size_t kMaxSpareSize = 1024 * 1024;
+
+  LogStream() = default;
+  ~LogStream() {
+    if (HALCYON_LOG_UNLIKELY(heap_ != nullptr)) {
+      recycle();
+    }
+  }
+
+  // The buffer may point into the stream itself.
+  LogStream(const LogStream&) = delete;
+  LogStream& operator=(const LogStream&) = delete;
+
+  LogStream& operator<<(bool v) { return append(v ? "true" : "false"); }
+  LogStream& operator<<(char v) { return append(std::string_view(&v, 1)); }
+  LogStream& operator<<(short v) { return appendInteger(v); }
+  LogStream& operator<<(unsigned short v) { return appendInteger(v); }
+  LogStream& operator<<(int v) { return appendInteger(v); }
+  LogStream& operator<<(unsigned int v) { return appendInteger(v); }
+  LogStream& operator<<(long v) { return appendInteger(v); }
+  LogStream& operator<<(unsigned long v) { return appendInteger(v); }
+  LogStream& operator<<(long long v) { return appendInteger(v); }
+  LogStream& operator<<(unsigned long long v) { return appendInteger(v); }
+  LogStream& operator<<(float v) { return appendFloat(v); }
+  LogStream& operator<<(double v) { return appendFloat(v); }
+  LogStream& operator<<(const void* p);
+  LogStream& operator<<(const char* s) { return append(s ? std::string_view(s) : "(null)"); }
+  LogStream& operator<<(std::string_view s) { return append(s); }
+  LogStream& operator<<(const std::string& s) { return append(s); }
+
+  std::string_view view() const { return std::string_view(data_, size_); }
+  // True once the message has outgrown the inline buffer.
+  bool spilled() const { return data_ != inline_; }
+
+ private:
+  LogStream& append(std::string_view s) {
+    std::memcpy(reserve(s.size()), s.data(), s.size());
+    size_ += s.size();
+    return *this;
+  }
+
+  // Returns room for at least `n` more bytes at the end of the message.
+  char* reserve(size_t n) {
+    if (HALCYON_LOG_UNLIKELY(capacity_ - size_ < n)) {
+      grow(n);
+    }
+    return data_ + size_;
+  }
+
+  HALCYON_LOG_NOINLINE void grow(size_t n);
+  HALCYON_LOG_NOINLINE void recycle();
+
+  template <typename T>
+  LogStream& appendInteger(T v);
+  template <typename T>
+  LogStream& appendFloat(T v);
+
+  char* data_ = inline_;
+  size_t size_ = 0;
+  size_t capacity_ = kInlineSize;
+  std::unique_ptr<char[]> heap_;
+  char inline_[kInlineSize];
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_LOG_STREAM_H
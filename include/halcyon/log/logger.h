@@ -0,0 +1,443 @@
+#ifndef HALCYON_LOG_LOGGER_H
+#define HALCYON_LOG_LOGGER_H
+
+#include <atomic>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+
+#include "halcyon/log/arg_codec.h"
+#include "halcyon/log/call_site.h"
+#include "halcyon/log/clock.h"
+#include "halcyon/log/key_value.h"
+#include "halcyon/log/level.h"
+#include "halcyon/log/log_stream.h"
+#include "halcyon/log/overflow_policy.h"
+#include "halcyon/log/platform.h"
+#include "halcyon/log/rate_limit.h"
+#include "halcyon/log/record.h"
+#include "halcyon/log/stats.h"
+#include "halcyon/log/thread_context.h"
+
+namespace halcyon::log {
+
+// Loggers form a tree by name: "net.http.client" is a child of "net.http",
+// which is a child of "net", which is a child of the root (named ""). A
+// logger without a level of its own inherits its parent's.
+//
+// The effective level is resolved whenever a level changes, into an atomic
+// that enabled() reads, so a level check costs one relaxed load no matter
+// how deep the logger is. Neither level changes nor lookups take a lock.
+class Logger {
+ public:
+  // A logger outside the named tree, with a level of its own; the root is
+  // one of these.
+  constexpr explicit Logger(Level level, OverflowPolicy overflow = OverflowPolicy::kBlock)
+      : level_(level), ownLevel_(static_cast<uint8_t>(level)), overflow_(overflow) {}
+
+  Logger(const Logger&) = delete;
+  Logger& operator=(const Logger&) = delete;
+
+  bool enabled(Level level) const { return level >= level_.load(std::memory_order_relaxed); }
+  // The effective level: the logger's own, or else the nearest ancestor's.
+  Level level() const { return level_.load(std::memory_order_relaxed); }
+  // Gives the logger a level of its own, which descendants without one of
+  // their own inherit. Takes effect in every thread without further
+  // synchronization.
+  void setLevel(Level level);
+  // Makes the logger inherit its parent's level again. No-op for loggers
+  // without a parent.
+  void clearLevel();
+  bool hasOwnLevel() const { return ownLevel_.load(std::memory_order_relaxed) != kInherit; }
+
+  // What this logger's statements do when the thread's staging ring is full.
+  // A named logger starts with its parent's policy.
+  OverflowPolicy overflowPolicy() const { return overflow_.load(std::memory_order_relaxed); }
+  void setOverflowPolicy(OverflowPolicy policy) {
+    overflow_.store(policy, std::memory_order_relaxed);
+  }
+
+  // The full dot-separated name; "" for the root.
+  std::string_view name() const { return name_; }
+  Logger* parent() const { return parent_; }
+
+  static Logger& root();
+
+  // The logger named `name`, created along with its missing ancestors on
+  // first use; empty components are skipped. Loggers are never destroyed,
+  // so the reference can be kept, and should be: each call walks the tree.
+  static Logger& get(std::string_view name);
+
+ private:
+  static constexpr uint8_t kInherit = 0xFF;
+
+  Logger(Logger* parent, std::string_view name, std::string_view leaf);
+
+  Logger& child(std::string_view leaf);
+  void refresh();
+
+  std::atomic<Level> level_;
+  std::atomic<uint8_t> ownLevel_;
+  std::atomic<OverflowPolicy> overflow_;
+  Logger* parent_ = nullptr;
+  std::string_view name_;
+  // The last component of the name.
+  std::string_view leaf_;
+  // Children are pushed onto the front of this list and never removed.
+  std::atomic<Logger*> firstChild_{nullptr};
+  Logger* nextSibling_ = nullptr;
+};
+
+namespace detail {
+
+extern constinit Logger gRootLogger;
+
+// Flushes the backend and aborts; called after a FATAL record is enqueued.
+[[noreturn]] void fatal();
+
+// Copies the statement's arguments into the calling thread's staging ring.
+// Formatting happens later, on the backend thread.
+template <typename... Args>
+void logCaptured(const Logger& logger, CallSite& site, const Args&... args) {
+  // The context comes first: a thread's first statement starts the backend,
+  // which selects the clock source that rawTimestamp() reads.
+  ThreadContext& context = ThreadContext::local();
+  uint64_t timestamp = rawTimestamp();
+  uint32_t siteId = site.id();
+  ArgEncoder<Args...> encoder;
+  size_t size = sizeof(RecordHeader) + encoder.size(args...);
+  size_t maxSize = context.ring().maxRecordSize();
+  if (HALCYON_LOG_UNLIKELY(size > maxSize)) {
+    size = sizeof(RecordHeader) + encoder.truncate(maxSize - sizeof(RecordHeader));
+  }
+
+  OverflowPolicy policy =
+      site.level == Level::kFatal ? OverflowPolicy::kBlock : logger.overflowPolicy();
+  char* p = context.prepareWrite(size, policy, site.level);
+  if (HALCYON_LOG_UNLIKELY(p == nullptr)) {
+    return;  // dropped and counted
+  }
+  char* end = encoder.encode(p + sizeof(RecordHeader), args...);
+  // Zero the alignment padding so that equal records are equal byte for
+  // byte; the backend compares them (BackendOptions::collapseDuplicates).
+  size_t alignedSize = SpscRing::alignedSize(size);
+  std::memset(end, 0, static_cast<size_t>(p + alignedSize - end));
+  RecordHeader header{static_cast<uint32_t>(alignedSize), siteId, timestamp};
+  std::memcpy(p, &header, sizeof(header));
+  context.commitWrite(static_cast<size_t>(end - p));
+  if (double nsPerTick = gEnqueueNsPerTick.load(std::memory_order_relaxed);
+      HALCYON_LOG_UNLIKELY(nsPerTick != 0)) {
+    auto ticks = static_cast<double>(rawTimestamp() - timestamp);
+    context.recordEnqueueLatency(static_cast<uint64_t>(ticks * nsPerTick));
+  }
+
+  if (site.level == Level::kFatal) {
+    fatal();
+  }
+}
+
+// Captures the fields of a structured statement as key, value, key, value...
+template <typename... Ts>
+void logFields(const Logger& logger, CallSite& site, const KeyValue<Ts>&... fields) {
+  std::apply([&](const auto&... args) { logCaptured(logger, site, args...); },
+             std::tuple_cat(std::tie(fields.key, fields.value)...));
+}
+
+}  // namespace detail
+
+inline Logger& Logger::root() { return detail::gRootLogger; }
+
+namespace detail {
+
+// Stands in for the stream of a statement that was compiled out. Never
+// constructed at run time; it only keeps the `<<` operands well-formed.
+struct NullStream {
+  NullStream() = default;
+  explicit NullStream(const Logger&) {}
+
+  template <typename T>
+  NullStream& operator<<(const T&) {
+    return *this;
+  }
+};
+
+// Keeps the arguments of a compiled-out LOGF statement type-checked and
+// "used" without evaluating them.
+template <typename... Args>
+constexpr void discard(const Args&...) {}
+
+}  // namespace detail
+
+// One `LOG_XXX << ...` statement. The streamed text is captured as the
+// single string argument of a "{}" call site when the temporary is destroyed
+// at the end of the full expression.
+class LogLine {
+ public:
+  LogLine(const Logger& logger, CallSite& site) : logger_(logger), site_(site) {}
+  ~LogLine() { detail::logCaptured(logger_, site_, stream_.view()); }
+
+  LogLine(const LogLine&) = delete;
+  LogLine& operator=(const LogLine&) = delete;
+
+  LogStream& stream() { return stream_; }
+
+ private:
+  const Logger& logger_;
+  CallSite& site_;
+  LogStream stream_;
+};
+
+}  // namespace halcyon::log
+
+#define HALCYON_LOG_STREAM(logger, level)                                                  \
+  if (const ::halcyon::log::Logger& hlogLogger_ = (logger); !hlogLogger_.enabled(level)) { \
+  } else                                                                                   \
+    switch (static constinit ::halcyon::log::CallSite hlogSite_{                           \
+                __FILE__, __func__, __LINE__, level, "{}",                                 \
+                ::halcyon::log::detail::kStreamSegments.data(), 1,                         \
+                ::halcyon::log::detail::ArgTypeList<std::string_view>::kTypes.data(), 1};  \
+            0)                                                                             \
+    default:                                                                               \
+      ::halcyon::log::LogLine(hlogLogger_, hlogSite_).stream()
+
+// Deferred formatting: only the argument bytes are copied on the calling
+// thread; the backend substitutes them for the `{}` placeholders in `fmt`.
+// `fmt` must be a string literal. It is parsed and checked against the
+// argument types at compile time, so placeholder count mismatches and specs
+// that do not fit the argument type fail to compile.
+#define HALCYON_LOGF(logger, level, fmt, ...)                                                 \
+  do {                                                                                        \
+    if (const ::halcyon::log::Logger& hlogLogger_ = (logger); hlogLogger_.enabled(level)) {   \
+      using HlogArgTypes_ = decltype(::halcyon::log::detail::argTypeList(__VA_ARGS__));       \
+      static constexpr auto hlogSegments_ =                                                   \
+          ::halcyon::log::detail::compileFormat<                                              \
+              ::halcyon::log::detail::countSegments(fmt), HlogArgTypes_>(fmt);                \
+      static constinit ::halcyon::log::CallSite hlogSite_{                                    \
+          __FILE__, __func__, __LINE__, level, fmt, hlogSegments_.data(),                     \
+          static_cast<uint32_t>(hlogSegments_.size()), HlogArgTypes_::kTypes.data(),          \
+          static_cast<uint32_t>(HlogArgTypes_::kTypes.size())};                               \
+      ::halcyon::log::detail::logCaptured(hlogLogger_, hlogSite_ __VA_OPT__(, ) __VA_ARGS__); \
+    }                                                                                         \
+  } while (0)
+
+// Structured logging: `msg` is a string literal without placeholders and
+// the remaining arguments are kv() fields, captured like LOGF_* arguments.
+// Rendered as `msg key=value ...` in the text layout and as fields of their
+// own in the JSON and logfmt layouts.
+#define HALCYON_LOGKV(logger, level, msg, ...)                                               \
+  do {                                                                                       \
+    if (const ::halcyon::log::Logger& hlogLogger_ = (logger); hlogLogger_.enabled(level)) {  \
+      using HlogArgTypes_ = decltype(::halcyon::log::detail::fieldTypeList(__VA_ARGS__));    \
+      static constexpr auto hlogSegments_ =                                                  \
+          ::halcyon::log::detail::compileFormat<::halcyon::log::detail::countSegments(msg),  \
+                                                ::halcyon::log::detail::ArgTypeList<>>(msg); \
+      static constinit ::halcyon::log::CallSite hlogSite_{                                   \
+          __FILE__, __func__, __LINE__, level, msg, hlogSegments_.data(),                    \
+          static_cast<uint32_t>(hlogSegments_.size()), HlogArgTypes_::kTypes.data(),         \
+          static_cast<uint32_t>(HlogArgTypes_::kTypes.size()), true};                        \
+      ::halcyon::log::detail::logFields(hlogLogger_, hlogSite_ __VA_OPT__(, ) __VA_ARGS__);  \
+    }                                                                                        \
+  } while (0)
+
+#define HALCYON_LOG_STREAM_DISABLED(logger) \
+  if (true) {                               \
+  } else                                    \
+    ::halcyon::log::detail::NullStream(logger)
+
+#define HALCYON_LOGF_DISABLED(...)                  \
+  do {                                              \
+    if (false) {                                    \
+      ::halcyon::log::detail::discard(__VA_ARGS__); \
+    }                                               \
+  } while (0)
+
+#define HALCYON_LOG_ROOT ::halcyon::log::Logger::root()
+
+#define HALCYON_LOG_UNPAREN(...) __VA_ARGS__
+#define HALCYON_LOG_SEVERITY(severity) \
+  static_cast<::halcyon::log::Level>(HALCYON_LOG_LEVEL_##severity)
+// False for statements below the compile-time floor, which then fold away.
+#define HALCYON_LOG_SEVERITY_ENABLED(severity)                 \
+  (HALCYON_LOG_LEVEL_##severity >= HALCYON_LOG_ACTIVE_LEVEL && \
+   HALCYON_LOG_ROOT.enabled(HALCYON_LOG_SEVERITY(severity)))
+
+// Rate-limited statements: `Limiter` is one of the SiteLimiter classes and
+// `limit` its parenthesized allow() arguments. The limiter is only consulted
+// once the level is enabled.
+#define HALCYON_LOG_STREAM_LIMITED(severity, Limiter, limit)                              \
+  if (!HALCYON_LOG_SEVERITY_ENABLED(severity)) {                                          \
+  } else                                                                                  \
+    switch (static constinit ::halcyon::log::CallSite hlogSite_{                          \
+                __FILE__, __func__, __LINE__, HALCYON_LOG_SEVERITY(severity), "{}",       \
+                ::halcyon::log::detail::kStreamSegments.data(), 1,                        \
+                ::halcyon::log::detail::ArgTypeList<std::string_view>::kTypes.data(), 1}; \
+            0)                                                                            \
+    default:                                                                              \
+      switch (static constinit ::halcyon::log::Limiter hlogLimiter_; 0)                   \
+      default:                                                                            \
+        if (!hlogLimiter_.allow(hlogSite_, HALCYON_LOG_UNPAREN limit)) {                  \
+        } else                                                                            \
+          ::halcyon::log::LogLine(HALCYON_LOG_ROOT, hlogSite_).stream()
+
+#define HALCYON_LOGF_LIMITED(severity, Limiter, limit, fmt, ...)                              \
+  do {                                                                                        \
+    if (HALCYON_LOG_SEVERITY_ENABLED(severity)) {                                             \
+      using HlogArgTypes_ = decltype(::halcyon::log::detail::argTypeList(__VA_ARGS__));       \
+      static constexpr auto hlogSegments_ =                                                   \
+          ::halcyon::log::detail::compileFormat<                                              \
+              ::halcyon::log::detail::countSegments(fmt), HlogArgTypes_>(fmt);                \
+      static constinit ::halcyon::log::CallSite hlogSite_{                                    \
+          __FILE__, __func__, __LINE__, HALCYON_LOG_SEVERITY(severity), fmt,                  \
+          hlogSegments_.data(), static_cast<uint32_t>(hlogSegments_.size()),                  \
+          HlogArgTypes_::kTypes.data(), static_cast<uint32_t>(HlogArgTypes_::kTypes.size())}; \
+      static constinit ::halcyon::log::Limiter hlogLimiter_;                                  \
+      if (hlogLimiter_.allow(hlogSite_, HALCYON_LOG_UNPAREN limit)) {                         \
+        ::halcyon::log::detail::logCaptured(HALCYON_LOG_ROOT,                                 \
+                                            hlogSite_ __VA_OPT__(, ) __VA_ARGS__);            \
+      }                                                                                       \
+    }                                                                                         \
+  } while (0)
+
+// `perSecond`, with a compile-time warning (from GCC) if it is known to be a
+// constant that is not positive. Evaluated once; the check itself does not
+// evaluate it unless it is a constant.
+#if defined(__GNUC__) && !defined(__clang__)
+#define HALCYON_LOG_CHECKED_RATE(perSecond)              \
+  (__builtin_constant_p(perSecond) && !((perSecond) > 0) \
+       ? ::halcyon::log::detail::rateNotPositive()       \
+       : (void)0,                                        \
+   (perSecond))
+#else
+#define HALCYON_LOG_CHECKED_RATE(perSecond) (perSecond)
+#endif
+
+// LOG_EVERY_N(WARN, 100) << ...: the 1st, 101st, 201st... execution.
+// LOG_FIRST_N(WARN, 10) << ...: the first 10 executions.
+// LOG_EVERY_T(WARN, 1s) << ...: at most one execution per std::chrono interval.
+// LOG_RATE_LIMIT(WARN, 50, 10) << ...: a token bucket refilled at 50 records
+// per second that allows bursts of up to 10.
+// The LOGF_ forms take the format string and arguments after the limit. The
+// severity is a level name; the records go through the root logger, and the
+// ones a limiter holds back are counted and reported by the backend.
+#define LOG_EVERY_N(severity, n) HALCYON_LOG_STREAM_LIMITED(severity, EveryN, (n))
+#define LOG_FIRST_N(severity, n) HALCYON_LOG_STREAM_LIMITED(severity, FirstN, (n))
+#define LOG_EVERY_T(severity, interval) HALCYON_LOG_STREAM_LIMITED(severity, EveryT, (interval))
+#define LOG_RATE_LIMIT(severity, perSecond, burst) \
+  HALCYON_LOG_STREAM_LIMITED(severity, TokenBucket, (HALCYON_LOG_CHECKED_RATE(perSecond), burst))
+#define LOGF_EVERY_N(severity, n, ...) HALCYON_LOGF_LIMITED(severity, EveryN, (n), __VA_ARGS__)
+#define LOGF_FIRST_N(severity, n, ...) HALCYON_LOGF_LIMITED(severity, FirstN, (n), __VA_ARGS__)
+#define LOGF_EVERY_T(severity, interval, ...) \
+  HALCYON_LOGF_LIMITED(severity, EveryT, (interval), __VA_ARGS__)
+#define LOGF_RATE_LIMIT(severity, perSecond, burst, ...)                                    \
+  HALCYON_LOGF_LIMITED(severity, TokenBucket, (HALCYON_LOG_CHECKED_RATE(perSecond), burst), \
+                       __VA_ARGS__)
+
+// LOG_INFO << ..., LOGF_INFO(fmt, ...) and LOGKV_INFO(msg, ...) log to the
+// root logger; the _TO forms take the logger as their first argument:
+//
+//   static auto& gHttpLog = halcyon::log::Logger::get("net.http");
+//   LOGF_DEBUG_TO(gHttpLog, "{} {}", method, path);
+
+#if HALCYON_LOG_ACTIVE_LEVEL <= HALCYON_LOG_LEVEL_TRACE
+#define LOG_TRACE HALCYON_LOG_STREAM(HALCYON_LOG_ROOT, ::halcyon::log::Level::kTrace)
+#define LOGF_TRACE(...) HALCYON_LOGF(HALCYON_LOG_ROOT, ::halcyon::log::Level::kTrace, __VA_ARGS__)
+#define LOGKV_TRACE(...) HALCYON_LOGKV(HALCYON_LOG_ROOT, ::halcyon::log::Level::kTrace, __VA_ARGS__)
+#define LOG_TRACE_TO(logger) HALCYON_LOG_STREAM(logger, ::halcyon::log::Level::kTrace)
+#define LOGF_TRACE_TO(logger, ...) HALCYON_LOGF(logger, ::halcyon::log::Level::kTrace, __VA_ARGS__)
+#define LOGKV_TRACE_TO(logger, ...) \
+  HALCYON_LOGKV(logger, ::halcyon::log::Level::kTrace, __VA_ARGS__)
+#else
+#define LOG_TRACE HALCYON_LOG_STREAM_DISABLED(HALCYON_LOG_ROOT)
+#define LOGF_TRACE(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOGKV_TRACE(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOG_TRACE_TO(logger) HALCYON_LOG_STREAM_DISABLED(logger)
+#define LOGF_TRACE_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#define LOGKV_TRACE_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#if HALCYON_LOG_ACTIVE_LEVEL <= HALCYON_LOG_LEVEL_DEBUG
+#define LOG_DEBUG HALCYON_LOG_STREAM(HALCYON_LOG_ROOT, ::halcyon::log::Level::kDebug)
+#define LOGF_DEBUG(...) HALCYON_LOGF(HALCYON_LOG_ROOT, ::halcyon::log::Level::kDebug, __VA_ARGS__)
+#define LOGKV_DEBUG(...) HALCYON_LOGKV(HALCYON_LOG_ROOT, ::halcyon::log::Level::kDebug, __VA_ARGS__)
+#define LOG_DEBUG_TO(logger) HALCYON_LOG_STREAM(logger, ::halcyon::log::Level::kDebug)
+#define LOGF_DEBUG_TO(logger, ...) HALCYON_LOGF(logger, ::halcyon::log::Level::kDebug, __VA_ARGS__)
+#define LOGKV_DEBUG_TO(logger, ...) \
+  HALCYON_LOGKV(logger, ::halcyon::log::Level::kDebug, __VA_ARGS__)
+#else
+#define LOG_DEBUG HALCYON_LOG_STREAM_DISABLED(HALCYON_LOG_ROOT)
+#define LOGF_DEBUG(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOGKV_DEBUG(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOG_DEBUG_TO(logger) HALCYON_LOG_STREAM_DISABLED(logger)
+#define LOGF_DEBUG_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#define LOGKV_DEBUG_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#if HALCYON_LOG_ACTIVE_LEVEL <= HALCYON_LOG_LEVEL_INFO
+#define LOG_INFO HALCYON_LOG_STREAM(HALCYON_LOG_ROOT, ::halcyon::log::Level::kInfo)
+#define LOGF_INFO(...) HALCYON_LOGF(HALCYON_LOG_ROOT, ::halcyon::log::Level::kInfo, __VA_ARGS__)
+#define LOGKV_INFO(...) HALCYON_LOGKV(HALCYON_LOG_ROOT, ::halcyon::log::Level::kInfo, __VA_ARGS__)
+#define LOG_INFO_TO(logger) HALCYON_LOG_STREAM(logger, ::halcyon::log::Level::kInfo)
+#define LOGF_INFO_TO(logger, ...) HALCYON_LOGF(logger, ::halcyon::log::Level::kInfo, __VA_ARGS__)
+#define LOGKV_INFO_TO(logger, ...) \
+  HALCYON_LOGKV(logger, ::halcyon::log::Level::kInfo, __VA_ARGS__)
+#else
+#define LOG_INFO HALCYON_LOG_STREAM_DISABLED(HALCYON_LOG_ROOT)
+#define LOGF_INFO(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOGKV_INFO(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOG_INFO_TO(logger) HALCYON_LOG_STREAM_DISABLED(logger)
+#define LOGF_INFO_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#define LOGKV_INFO_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#if HALCYON_LOG_ACTIVE_LEVEL <= HALCYON_LOG_LEVEL_WARN
+#define LOG_WARN HALCYON_LOG_STREAM(HALCYON_LOG_ROOT, ::halcyon::log::Level::kWarn)
+#define LOGF_WARN(...) HALCYON_LOGF(HALCYON_LOG_ROOT, ::halcyon::log::Level::kWarn, __VA_ARGS__)
+#define LOGKV_WARN(...) HALCYON_LOGKV(HALCYON_LOG_ROOT, ::halcyon::log::Level::kWarn, __VA_ARGS__)
+#define LOG_WARN_TO(logger) HALCYON_LOG_STREAM(logger, ::halcyon::log::Level::kWarn)
+#define LOGF_WARN_TO(logger, ...) HALCYON_LOGF(logger, ::halcyon::log::Level::kWarn, __VA_ARGS__)
+#define LOGKV_WARN_TO(logger, ...) \
+  HALCYON_LOGKV(logger, ::halcyon::log::Level::kWarn, __VA_ARGS__)
+#else
+#define LOG_WARN HALCYON_LOG_STREAM_DISABLED(HALCYON_LOG_ROOT)
+#define LOGF_WARN(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOGKV_WARN(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOG_WARN_TO(logger) HALCYON_LOG_STREAM_DISABLED(logger)
+#define LOGF_WARN_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#define LOGKV_WARN_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#if HALCYON_LOG_ACTIVE_LEVEL <= HALCYON_LOG_LEVEL_ERROR
+#define LOG_ERROR HALCYON_LOG_STREAM(HALCYON_LOG_ROOT, ::halcyon::log::Level::kError)
+#define LOGF_ERROR(...) HALCYON_LOGF(HALCYON_LOG_ROOT, ::halcyon::log::Level::kError, __VA_ARGS__)
+#define LOGKV_ERROR(...) HALCYON_LOGKV(HALCYON_LOG_ROOT, ::halcyon::log::Level::kError, __VA_ARGS__)
+#define LOG_ERROR_TO(logger) HALCYON_LOG_STREAM(logger, ::halcyon::log::Level::kError)
+#define LOGF_ERROR_TO(logger, ...) HALCYON_LOGF(logger, ::halcyon::log::Level::kError, __VA_ARGS__)
+#define LOGKV_ERROR_TO(logger, ...) \
+  HALCYON_LOGKV(logger, ::halcyon::log::Level::kError, __VA_ARGS__)
+#else
+#define LOG_ERROR HALCYON_LOG_STREAM_DISABLED(HALCYON_LOG_ROOT)
+#define LOGF_ERROR(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOGKV_ERROR(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOG_ERROR_TO(logger) HALCYON_LOG_STREAM_DISABLED(logger)
+#define LOGF_ERROR_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#define LOGKV_ERROR_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#if HALCYON_LOG_ACTIVE_LEVEL <= HALCYON_LOG_LEVEL_FATAL
+#define LOG_FATAL HALCYON_LOG_STREAM(HALCYON_LOG_ROOT, ::halcyon::log::Level::kFatal)
+#define LOGF_FATAL(...) HALCYON_LOGF(HALCYON_LOG_ROOT, ::halcyon::log::Level::kFatal, __VA_ARGS__)
+#define LOGKV_FATAL(...) HALCYON_LOGKV(HALCYON_LOG_ROOT, ::halcyon::log::Level::kFatal, __VA_ARGS__)
+#define LOG_FATAL_TO(logger) HALCYON_LOG_STREAM(logger, ::halcyon::log::Level::kFatal)
+#define LOGF_FATAL_TO(logger, ...) HALCYON_LOGF(logger, ::halcyon::log::Level::kFatal, __VA_ARGS__)
+#define LOGKV_FATAL_TO(logger, ...) \
+  HALCYON_LOGKV(logger, ::halcyon::log::Level::kFatal, __VA_ARGS__)
+#else
+#define LOG_FATAL HALCYON_LOG_STREAM_DISABLED(HALCYON_LOG_ROOT)
+#define LOGF_FATAL(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOGKV_FATAL(...) HALCYON_LOGF_DISABLED(__VA_ARGS__)
+#define LOG_FATAL_TO(logger) HALCYON_LOG_STREAM_DISABLED(logger)
+#define LOGF_FATAL_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#define LOGKV_FATAL_TO(logger, ...) HALCYON_LOGF_DISABLED(logger, __VA_ARGS__)
+#endif
+
+#endif  // HALCYON_LOG_LOGGER_H
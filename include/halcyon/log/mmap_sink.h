@@ -0,0 +1,80 @@
+#ifndef HALCYON_LOG_MMAP_SINK_H
+#define HALCYON_LOG_MMAP_SINK_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "halcyon/log/sink.h"
+
+namespace halcyon::log {
+
+struct MmapFileSinkOptions {
+  // Bytes preallocated and mapped per segment file.
+  size_t segmentSize = 64 * 1024 * 1024;
+};
+
+// Writes lines into fixed-size, preallocated segment files mapped into
+// memory, so writing a line is a memcpy and needs no system call. Segments
+// are named `<path>.000000`, `<path>.000001`, ..., skipping names that
+// already exist. A background thread prepares the next segment ahead of time
+// and syncs, unmaps and truncates each full one to its used size.
+//
+// A line that does not fit in what is left of a segment starts the next
+// one, so every segment holds whole lines. A line longer than segmentSize
+// is truncated to that size.
+//
+// Lines are in the page cache as soon as they are written, so they survive
+// a crash of the process (not of the machine). A segment left behind by a
+// crash keeps its preallocated size, padded with zero bytes.
+class MmapFileSink : public Sink {
+ public:
+  // Throws std::system_error if the first segment cannot be created.
+  explicit MmapFileSink(const std::string& path, const MmapFileSinkOptions& options = {});
+  ~MmapFileSink() override;
+
+  MmapFileSink(const MmapFileSink&) = delete;
+  MmapFileSink& operator=(const MmapFileSink&) = delete;
+
+  void write(std::string_view line) override;
+  // The data is already in the page cache; nothing to do.
+  void flush() override {}
+
+ private:
+  struct Segment {
+    std::string path;
+    int fd = -1;
+    char* data = nullptr;
+    size_t used = 0;
+  };
+
+  // Returns 0 or an errno value.
+  int createSegment(Segment& segment);
+  void closeSegment(Segment& segment);
+  void roll();
+  void run();
+
+  const std::string path_;
+  const MmapFileSinkOptions options_;
+  Segment current_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable spareReady_;
+  uint32_t nextIndex_ = 0;
+  Segment spare_;
+  bool spareFailed_ = false;
+  std::vector<Segment> retired_;
+  bool stopping_ = false;
+  int lastError_ = 0;
+  std::thread thread_;
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_MMAP_SINK_H
@@ -0,0 +1,36 @@
+#ifndef HALCYON_LOG_NUMA_H
+#define HALCYON_LOG_NUMA_H
+
+#include <cstddef>
+#include <vector>
+
+// The NUMA topology as Linux reports it under /sys/devices/system/node, and
+// the few system calls the sharded backend needs, made directly so that
+// libnuma is not required.
+
+namespace halcyon::log {
+
+struct NumaNode {
+  int id = 0;
+  std::vector<int> cpus;
+};
+
+// The online nodes that have CPUs, by id. Empty where the topology cannot be
+// read (not Linux, or sysfs not mounted).
+std::vector<NumaNode> numaNodes();
+
+// The node the calling thread is running on, or -1 if unknown.
+int currentNumaNode();
+
+// Restricts the calling thread to `cpus`. Returns false if the kernel
+// refused.
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+// Asks the kernel to keep the pages of [data, data + size) on `node`, moving
+// those already faulted in elsewhere. Only pages wholly inside the range are
+// affected. Returns false if that failed; the memory is usable either way.
+bool bindToNode(void* data, size_t size, int node);
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_NUMA_H
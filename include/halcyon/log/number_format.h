@@ -0,0 +1,101 @@
+#ifndef HALCYON_LOG_NUMBER_FORMAT_H
+#define HALCYON_LOG_NUMBER_FORMAT_H
+
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Number to text conversions used by the formatter and LogStream. They
+// write into a caller-provided buffer and return the end of what they
+// wrote; none of them goes through stdio or iostreams.
+
+namespace halcyon::log::detail {
+
+// "00" "01" ... "99": two digits per lookup.
+inline constexpr char kDigitPairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+inline constexpr uint64_t kPowersOf10[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+// Longest output of formatUnsigned(), formatSigned() and formatHex().
+inline constexpr size_t kMaxIntegerChars = 20;
+
+inline void putPair(char* p, unsigned v) { std::memcpy(p, kDigitPairs + 2 * v, 2); }
+
+// Number of decimal digits of `v` (1 for 0). The bit width gives the
+// digit count to within one (1233 / 4096 approximates log10(2)); a single
+// table comparison settles it, instead of a chain of compares.
+inline int countDigits(uint64_t v) {
+  v |= 1;  // same count, and 0 takes one digit
+  int guess = (std::bit_width(v) * 1233) >> 12;
+  return guess + 1 - (v < kPowersOf10[guess] ? 1 : 0);
+}
+
+// Writes the digits of `v` backwards from `end`, two at a time.
+template <typename T>
+inline void writeDigits(char* end, T v) {
+  while (v >= 100) {
+    end -= 2;
+    putPair(end, static_cast<unsigned>(v % 100));
+    v /= 100;
+  }
+  if (v >= 10) {
+    putPair(end - 2, static_cast<unsigned>(v));
+  } else {
+    end[-1] = static_cast<char>('0' + v);
+  }
+}
+
+inline char* formatUnsigned(char* out, uint64_t v) {
+  char* end = out + countDigits(v);
+  // Most values fit 32 bits, where dividing by 100 is a cheaper multiply.
+  if (v <= UINT32_MAX) {
+    writeDigits(end, static_cast<uint32_t>(v));
+  } else {
+    writeDigits(end, v);
+  }
+  return end;
+}
+
+inline char* formatSigned(char* out, int64_t v) {
+  auto u = static_cast<uint64_t>(v);
+  if (v < 0) {
+    *out++ = '-';
+    u = 0 - u;
+  }
+  return formatUnsigned(out, u);
+}
+
+inline char* formatHex(char* out, uint64_t v, bool upper = false) {
+  const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  char* end = out + (std::bit_width(v | 1) + 3) / 4;
+  for (char* p = end; p != out; v >>= 4) {
+    *--p = digits[v & 15];
+  }
+  return end;
+}
+
+// Shortest text that reads back as the same value. libstdc++ implements
+// to_chars with Ryu, which is what this relies on for speed.
+inline char* formatShortest(char* out, char* end, double v) {
+  return std::to_chars(out, end, v).ptr;
+}
+
+// Fixed notation with `precision` digits after the point, rounded exactly
+// as printf does. Common cases are scaled to an integer and printed with
+// formatUnsigned(); the rest go through to_chars.
+char* formatFixed(char* out, char* end, double v, int precision);
+
+}  // namespace halcyon::log::detail
+
+#endif  // HALCYON_LOG_NUMBER_FORMAT_H
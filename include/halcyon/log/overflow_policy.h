@@ -0,0 +1,26 @@
+#ifndef HALCYON_LOG_OVERFLOW_POLICY_H
+#define HALCYON_LOG_OVERFLOW_POLICY_H
+
+#include <cstdint>
+
+namespace halcyon::log {
+
+// What a log statement does when the calling thread's staging ring is full.
+// FATAL records always block, whatever the policy.
+enum class OverflowPolicy : uint8_t {
+  // Sleep until the backend has made room.
+  kBlock,
+  // Busy-wait briefly for room, then sleep as kBlock does.
+  kSpinThenBlock,
+  // Discard the new record.
+  kDropNewest,
+  // Discard the oldest records in the ring until the new one fits. Until
+  // the backend has switched the thread's ring to overwrite mode, shortly
+  // after the thread first logs with this policy, new records are dropped
+  // instead.
+  kOverwriteOldest,
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_OVERFLOW_POLICY_H
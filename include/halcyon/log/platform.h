@@ -0,0 +1,36 @@
+#ifndef HALCYON_LOG_PLATFORM_H
+#define HALCYON_LOG_PLATFORM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HALCYON_LOG_LIKELY(x) __builtin_expect(!!(x), 1)
+#define HALCYON_LOG_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define HALCYON_LOG_NOINLINE __attribute__((noinline))
+#else
+#define HALCYON_LOG_LIKELY(x) (x)
+#define HALCYON_LOG_UNLIKELY(x) (x)
+#define HALCYON_LOG_NOINLINE
+#endif
+
+namespace halcyon::log {
+
+// Used to pad hot atomics so producers and the backend never false-share.
+inline constexpr size_t kCacheLineSize = 64;
+
+// Kernel thread id of the caller, cached per thread.
+uint32_t currentThreadId();
+
+// Spin-wait hint.
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_PLATFORM_H
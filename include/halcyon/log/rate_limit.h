@@ -0,0 +1,166 @@
+#ifndef HALCYON_LOG_RATE_LIMIT_H
+#define HALCYON_LOG_RATE_LIMIT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "halcyon/log/call_site.h"
+#include "halcyon/log/platform.h"
+
+namespace halcyon::log {
+
+class Backend;
+
+// State of one rate-limited statement (LOG_EVERY_N and friends), kept as a
+// constant-initialized static next to its call site and shared by every
+// thread that runs the statement. allow() decides whether this execution
+// logs; those that do not are counted, and the backend reports the counts
+// along with its drop report (BackendOptions::dropReportInterval).
+class SiteLimiter {
+ public:
+  constexpr SiteLimiter() = default;
+
+  SiteLimiter(const SiteLimiter&) = delete;
+  SiteLimiter& operator=(const SiteLimiter&) = delete;
+
+  // Executions suppressed so far.
+  uint64_t suppressed() const { return suppressed_.load(std::memory_order_relaxed); }
+  // The statement's call site; null until it first suppressed anything.
+  const CallSite* site() const { return site_; }
+
+  // Every limiter that has suppressed anything, most recent first. The list
+  // only grows, and may be walked from any thread.
+  static SiteLimiter* first();
+  SiteLimiter* next() const { return next_; }
+
+ protected:
+  void suppress(const CallSite& site) {
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    if (HALCYON_LOG_UNLIKELY(!linked_.load(std::memory_order_relaxed))) {
+      link(site);
+    }
+  }
+
+  static int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+ private:
+  friend class Backend;
+
+  HALCYON_LOG_NOINLINE void link(const CallSite& site);
+
+  std::atomic<uint64_t> suppressed_{0};
+  std::atomic<bool> linked_{false};
+  const CallSite* site_ = nullptr;
+  SiteLimiter* next_ = nullptr;
+  // Written by the backend thread only.
+  uint64_t reported_ = 0;
+};
+
+// The 1st, (n+1)th, (2n+1)th... execution.
+class EveryN : public SiteLimiter {
+ public:
+  bool allow(const CallSite& site, uint64_t n) {
+    if (count_.fetch_add(1, std::memory_order_relaxed) % std::max<uint64_t>(n, 1) == 0) {
+      return true;
+    }
+    suppress(site);
+    return false;
+  }
+
+ private:
+  std::atomic<uint64_t> count_{0};
+};
+
+// The first n executions. Once they are used up this is a plain load.
+class FirstN : public SiteLimiter {
+ public:
+  bool allow(const CallSite& site, uint64_t n) {
+    if (count_.load(std::memory_order_relaxed) < n &&
+        count_.fetch_add(1, std::memory_order_relaxed) < n) {
+      return true;
+    }
+    suppress(site);
+    return false;
+  }
+
+ private:
+  std::atomic<uint64_t> count_{0};
+};
+
+// At most one execution per interval.
+class EveryT : public SiteLimiter {
+ public:
+  bool allow(const CallSite& site, std::chrono::nanoseconds interval) {
+    int64_t t = now();
+    int64_t due = due_.load(std::memory_order_relaxed);
+    if (t >= due && due_.compare_exchange_strong(due, t + interval.count(),
+                                                 std::memory_order_relaxed)) {
+      return true;
+    }
+    suppress(site);
+    return false;
+  }
+
+ private:
+  std::atomic<int64_t> due_{0};
+};
+
+// A token bucket holding up to `burst` tokens and refilled at `perSecond`
+// tokens per second; each execution that logs takes one. Kept as a single
+// atomic in the form of the generic cell rate algorithm: the time at which
+// the bucket will be full again advances by one refill interval per record,
+// and a record is allowed while that time is less than `burst` intervals
+// ahead of now.
+//
+// A rate that is not positive (or NaN) never refills: only the first `burst`
+// executions log, as if time stood still. Tiny rates are clamped so that
+// `burst` refill intervals still fit the clock's range.
+class TokenBucket : public SiteLimiter {
+ public:
+  bool allow(const CallSite& site, double perSecond, uint32_t burst) {
+    burst = std::max<uint32_t>(burst, 1);
+    int64_t interval = 1;
+    int64_t t = 0;
+    if (perSecond > 0) {
+      double maxInterval = 0x1p62 / burst;
+      double ns = 1e9 / perSecond;
+      interval = static_cast<int64_t>(ns < maxInterval ? ns : maxInterval);
+      t = now();
+    }
+    int64_t tolerance = interval * (static_cast<int64_t>(burst) - 1);
+    int64_t full = full_.load(std::memory_order_relaxed);
+    for (;;) {
+      int64_t from = std::max(full, t);
+      if (from - t > tolerance) {
+        suppress(site);
+        return false;
+      }
+      if (full_.compare_exchange_weak(full, from + interval, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+  }
+
+ private:
+  std::atomic<int64_t> full_{0};
+};
+
+namespace detail {
+
+// Only referenced, and then a compile-time warning, for a constant rate
+// that is not positive (see HALCYON_LOG_CHECKED_RATE). Defined, so that the
+// call links in builds that keep it.
+[[gnu::warning("LOG_RATE_LIMIT: perSecond is not positive; the bucket never refills")]] void
+rateNotPositive();
+
+}  // namespace detail
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_RATE_LIMIT_H
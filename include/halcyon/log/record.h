@@ -0,0 +1,31 @@
+#ifndef HALCYON_LOG_RECORD_H
+#define HALCYON_LOG_RECORD_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "halcyon/log/call_site.h"
+
+namespace halcyon::log {
+
+// Layout of a record in a thread's staging ring. The encoded arguments
+// follow the header directly, see arg_codec.h.
+struct RecordHeader {
+  uint32_t size;    // total size in the ring, see SpscRing
+  uint32_t siteId;  // see CallSiteRegistry
+  uint64_t timestamp;  // raw clock reading, see rawTimestamp()
+};
+
+// A record as seen by the backend formatter; `site` is resolved from the
+// registry and `args` points into the ring.
+struct Record {
+  int64_t timestamp = 0;  // nanoseconds since the Unix epoch
+  uint32_t threadId = 0;
+  uint32_t siteId = 0;
+  const CallSite* site = nullptr;
+  std::string_view args;
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_RECORD_H
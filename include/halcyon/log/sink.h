@@ -0,0 +1,122 @@
+#ifndef HALCYON_LOG_SINK_H
+#define HALCYON_LOG_SINK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "halcyon/log/binary_format.h"
+#include "halcyon/log/file_writer.h"
+#include "halcyon/log/formatter.h"
+#include "halcyon/log/level.h"
+#include "halcyon/log/record.h"
+
+namespace halcyon::log {
+
+// Destination for log records. Sinks are only ever called from the backend
+// thread, so implementations need no locking of their own.
+//
+// Text sinks receive the line the backend formatted once for all sinks of
+// the same layout through write(). Sinks that encode records themselves
+// return false from wantsText() and receive writeRecord() instead; a record
+// is only formatted in the layouts some sink that takes it wants.
+class Sink {
+ public:
+  virtual ~Sink() = default;
+
+  // Records below `level` are not given to this sink. Can be changed at any
+  // time, from any thread. Virtual so that wrappers can forward them.
+  virtual void setLevel(Level level) { level_.store(level, std::memory_order_relaxed); }
+  virtual Level level() const { return level_.load(std::memory_order_relaxed); }
+
+  // How a text sink's lines are rendered; BackendOptions::layout unless set.
+  // Must be set before the backend starts.
+  virtual void setLayout(Layout layout) { layout_ = layout; }
+  virtual std::optional<Layout> layout() const { return layout_; }
+
+  virtual bool wantsText() const { return true; }
+
+  // `line` is a complete line including the trailing newline.
+  virtual void write(std::string_view line) { (void)line; }
+  virtual void writeRecord(const Record& record) { (void)record; }
+
+  // Returns once everything written so far has reached the OS. Called for
+  // Backend::flush() and on stop.
+  virtual void flush() = 0;
+  // Called on the backend's flush interval: starts writing what is buffered
+  // without waiting for it. Sinks that write in the background override it.
+  virtual void flushAsync() { flush(); }
+
+  // Bytes given to this sink so far: the lines for text sinks, and what the
+  // sink reported through addBytesWritten() otherwise. Safe to call from any
+  // thread.
+  uint64_t bytesWritten() const { return bytesWritten_.load(std::memory_order_relaxed); }
+
+ protected:
+  // Backend thread only.
+  void addBytesWritten(uint64_t n) {
+    bytesWritten_.store(bytesWritten_.load(std::memory_order_relaxed) + n,
+                        std::memory_order_relaxed);
+  }
+
+ private:
+  friend class Backend;
+
+  std::atomic<Level> level_{Level::kTrace};
+  std::optional<Layout> layout_;
+  std::atomic<uint64_t> bytesWritten_{0};
+};
+
+// Writes to stdout or stderr through stdio buffering.
+class ConsoleSink : public Sink {
+ public:
+  explicit ConsoleSink(bool useStderr = false);
+
+  void write(std::string_view line) override;
+  void flush() override;
+
+ private:
+  FILE* stream_;
+};
+
+// Appends to a file. Lines are batched in large buffers that a background
+// flusher writes, so the backend never waits on the disk unless every buffer
+// is in flight.
+class FileSink : public Sink {
+ public:
+  // Throws std::system_error if the file cannot be opened.
+  explicit FileSink(const std::string& path, const FileSinkOptions& options = {});
+
+  void write(std::string_view line) override;
+  void flush() override;
+  void flushAsync() override;
+
+ private:
+  FileWriter writer_;
+};
+
+// Writes the compact binary format described in binary_format.h. Use the
+// halcyon_log_decode tool to turn the file back into text. The rotation
+// options do not apply.
+class BinaryFileSink : public Sink {
+ public:
+  // Truncates the file. Throws std::system_error if it cannot be opened.
+  explicit BinaryFileSink(const std::string& path, const FileSinkOptions& options = {});
+
+  bool wantsText() const override { return false; }
+  void writeRecord(const Record& record) override;
+  void flush() override;
+  void flushAsync() override;
+
+ private:
+  FileWriter writer_;
+  binary::Encoder encoder_;
+  std::string frame_;
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_SINK_H
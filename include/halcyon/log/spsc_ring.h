@@ -0,0 +1,232 @@
+#ifndef HALCYON_LOG_SPSC_RING_H
+#define HALCYON_LOG_SPSC_RING_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "halcyon/log/platform.h"
+
+namespace halcyon::log {
+
+// Single-producer / single-consumer ring of variable-length records.
+//
+// Every record starts with a uint32_t holding its total size (rounded up to
+// kRecordAlignment), so the consumer can walk the ring without knowing the
+// record layout. Records never straddle the end of the buffer: when one does
+// not fit in the remaining tail the producer writes a wrap marker and starts
+// over at offset zero.
+//
+// Positions grow monotonically and are only masked when indexing. Each side
+// keeps a private copy of the other side's position and only reloads the
+// shared atomic when that copy says the ring is full (or empty), so in steady
+// state the two threads do not touch each other's cache lines.
+//
+// A full ring can also make room by discarding its oldest records
+// (discardOldest()), which means the producer advancing the read position.
+// The consumer then has to stop reading records in place: once it has
+// acknowledged overwrite mode it copies each record out and claims it with a
+// compare-and-swap on the read position, and a failed claim means the
+// producer discarded the record while it was being copied.
+class SpscRing {
+ public:
+  static constexpr size_t kRecordAlignment = 8;
+
+  // capacity must be a power of two and a multiple of kRecordAlignment.
+  explicit SpscRing(size_t capacity)
+      : SpscRing(std::make_unique_for_overwrite<char[]>(capacity), capacity) {}
+  // Runs on `buffer`, which must hold `capacity` bytes; its contents do not
+  // matter.
+  SpscRing(std::unique_ptr<char[]> buffer, size_t capacity)
+      : capacity_(capacity), mask_(capacity - 1), buffer_(std::move(buffer)) {
+    assert(capacity >= 64 && (capacity & (capacity - 1)) == 0);
+  }
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  static constexpr size_t alignedSize(size_t size) {
+    return (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  // Hands the buffer over for reuse by another ring. The ring must not be
+  // used afterwards.
+  std::unique_ptr<char[]> releaseBuffer() { return std::move(buffer_); }
+
+  // Largest record that is guaranteed to fit once the ring has drained.
+  size_t maxRecordSize() const { return capacity_ / 2; }
+
+  // Producer: returns space for `size` contiguous bytes, or nullptr if the
+  // ring is currently too full. The first four bytes of the record must hold
+  // alignedSize(size) by the time commitWrite() is called.
+  char* prepareWrite(size_t size) {
+    size = alignedSize(size);
+    size_t offset = writePos_ & mask_;
+    size_t tailRoom = capacity_ - offset;
+    size_t needed = size <= tailRoom ? size : tailRoom + size;
+    if (writePos_ + needed - cachedReadPos_ > capacity_) {
+      cachedReadPos_ = publishedReadPos_.load(std::memory_order_acquire);
+      if (writePos_ + needed - cachedReadPos_ > capacity_) {
+        return nullptr;
+      }
+    }
+    if (size > tailRoom) {
+      storeSize(buffer_.get() + offset, kWrapMarker);
+      writePos_ += tailRoom;
+      offset = 0;
+    }
+    return buffer_.get() + offset;
+  }
+
+  // Producer: publishes the record returned by the last prepareWrite().
+  void commitWrite(size_t size) {
+    writePos_ += alignedSize(size);
+    publishedWritePos_.store(writePos_, std::memory_order_release);
+  }
+
+  // Producer: asks the consumer to switch to overwrite mode, which it does
+  // the next time it looks for a record.
+  void requestOverwrite() { overwriteRequested_.store(true, std::memory_order_relaxed); }
+
+  // Producer: true once the consumer has switched to overwrite mode, after
+  // which discardOldest() may be used.
+  bool overwriteEnabled() const { return overwriteAcked_.load(std::memory_order_acquire); }
+
+  // Producer, overwrite mode: frees the oldest record. Returns it (its bytes
+  // stay intact until the producer writes again), or nullptr if nothing was
+  // freed or only a wrap marker was.
+  const char* discardOldest() {
+    size_t readPos = publishedReadPos_.load(std::memory_order_acquire);
+    if (readPos == writePos_) {
+      return nullptr;
+    }
+    size_t offset = readPos & mask_;
+    const char* record = buffer_.get() + offset;
+    uint32_t size = loadSize(record);
+    size_t next = readPos + (size == kWrapMarker ? capacity_ - offset : size);
+    if (!publishedReadPos_.compare_exchange_strong(readPos, next, std::memory_order_acq_rel)) {
+      return nullptr;  // the consumer took it; the caller retries
+    }
+    cachedReadPos_ = next;
+    return size == kWrapMarker ? nullptr : record;
+  }
+
+  // Consumer: returns the next record, or nullptr if the ring is empty. In
+  // overwrite mode the record is a private copy and has already been
+  // released; finishRead() is then a no-op.
+  const char* prepareRead() {
+    if (HALCYON_LOG_UNLIKELY(overwriteRequested_.load(std::memory_order_relaxed))) {
+      if (!overwriteMode_) {
+        // Between records, so nothing is being read in place.
+        overwriteMode_ = true;
+        overwriteAcked_.store(true, std::memory_order_release);
+      }
+      return copyNext();
+    }
+    if (readPos_ == cachedWritePos_) {
+      cachedWritePos_ = publishedWritePos_.load(std::memory_order_acquire);
+      if (readPos_ == cachedWritePos_) {
+        return nullptr;
+      }
+    }
+    size_t offset = readPos_ & mask_;
+    if (loadSize(buffer_.get() + offset) == kWrapMarker) {
+      readPos_ += capacity_ - offset;
+      offset = 0;
+    }
+    return buffer_.get() + offset;
+  }
+
+  // Consumer: releases the record returned by the last prepareRead().
+  void finishRead(size_t size) {
+    if (overwriteMode_) {
+      return;
+    }
+    readPos_ += alignedSize(size);
+    publishedReadPos_.store(readPos_, std::memory_order_release);
+  }
+
+  // True if nothing is left to read.
+  bool empty() const {
+    return publishedReadPos_.load(std::memory_order_acquire) ==
+           publishedWritePos_.load(std::memory_order_acquire);
+  }
+
+  // Bytes waiting to be read, including padding before a wrap.
+  size_t size() const {
+    // Read position first: it never passes the write position.
+    size_t readPos = publishedReadPos_.load(std::memory_order_acquire);
+    return publishedWritePos_.load(std::memory_order_acquire) - readPos;
+  }
+
+  static uint32_t loadSize(const char* record) {
+    uint32_t size;
+    std::memcpy(&size, record, sizeof(size));
+    return size;
+  }
+
+  static void storeSize(char* record, uint32_t size) { std::memcpy(record, &size, sizeof(size)); }
+
+ private:
+  static constexpr uint32_t kWrapMarker = UINT32_MAX;
+
+  const char* copyNext() {
+    for (;;) {
+      size_t start = publishedReadPos_.load(std::memory_order_acquire);
+      size_t writePos = publishedWritePos_.load(std::memory_order_acquire);
+      if (start == writePos) {
+        return nullptr;
+      }
+      size_t readPos = start;
+      size_t offset = readPos & mask_;
+      uint32_t size = loadSize(buffer_.get() + offset);
+      if (size == kWrapMarker) {
+        readPos += capacity_ - offset;
+        offset = 0;
+        size = loadSize(buffer_.get());
+      }
+      // The bytes can be torn by a concurrent discard; the claim below
+      // catches that, this only keeps the copy in bounds.
+      if (size == 0 || size > capacity_ - offset || readPos + size > writePos) {
+        continue;
+      }
+      copy_.resize(size);
+      std::memcpy(copy_.data(), buffer_.get() + offset, size);
+      if (publishedReadPos_.compare_exchange_strong(start, readPos + size,
+                                                    std::memory_order_acq_rel)) {
+        return copy_.data();
+      }
+    }
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<char[]> buffer_;
+
+  // Producer side.
+  alignas(kCacheLineSize) size_t writePos_ = 0;
+  size_t cachedReadPos_ = 0;
+  alignas(kCacheLineSize) std::atomic<size_t> publishedWritePos_{0};
+
+  // Consumer side.
+  alignas(kCacheLineSize) size_t readPos_ = 0;
+  size_t cachedWritePos_ = 0;
+  bool overwriteMode_ = false;
+  std::vector<char> copy_;
+  alignas(kCacheLineSize) std::atomic<size_t> publishedReadPos_{0};
+
+  // Overwrite handshake; written once each.
+  alignas(kCacheLineSize) std::atomic<bool> overwriteRequested_{false};
+  std::atomic<bool> overwriteAcked_{false};
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_SPSC_RING_H
@@ -0,0 +1,127 @@
+#ifndef HALCYON_LOG_STATS_H
+#define HALCYON_LOG_STATS_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "halcyon/log/level.h"
+
+namespace halcyon::log {
+
+// Log-linear histogram buckets: every power of two is split into
+// kSubBuckets equal ranges, so a bucket is at most 25% wide. Values from
+// 2^kMaxExponent nanoseconds (about 18 minutes) on share the last bucket.
+struct HistogramBuckets {
+  static constexpr int kSubBits = 2;
+  static constexpr int kSubBuckets = 1 << kSubBits;
+  static constexpr int kMaxExponent = 40;
+  static constexpr int kCount = kSubBuckets * (kMaxExponent - kSubBits + 1);
+
+  static constexpr int indexOf(uint64_t value) {
+    if (value < kSubBuckets) {
+      return static_cast<int>(value);
+    }
+    int exponent = std::bit_width(value) - 1;
+    if (exponent >= kMaxExponent) {
+      return kCount - 1;
+    }
+    int sub = static_cast<int>(value >> (exponent - kSubBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBits + 1) * kSubBuckets + sub;
+  }
+
+  // Largest value that falls into bucket `index`.
+  static constexpr uint64_t upperBound(int index) {
+    if (index < kSubBuckets) {
+      return static_cast<uint64_t>(index);
+    }
+    int exponent = index / kSubBuckets + kSubBits - 1;
+    uint64_t sub = static_cast<uint64_t>(index % kSubBuckets);
+    return ((kSubBuckets + sub + 1) << (exponent - kSubBits)) - 1;
+  }
+};
+
+// Point-in-time copy of a LatencyHistogram. All values are nanoseconds.
+struct HistogramSnapshot {
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t max = 0;
+  std::array<uint64_t, HistogramBuckets::kCount> buckets{};
+
+  // Upper bound of the bucket holding the `q` quantile (0 <= q <= 1), capped
+  // at max; 0 if the histogram is empty.
+  uint64_t percentile(double q) const;
+  uint64_t mean() const { return count == 0 ? 0 : sum / count; }
+
+  void merge(const HistogramSnapshot& other);
+};
+
+// Histogram of durations in nanoseconds. One thread records into it while
+// any thread may take snapshots; nothing is locked and recording is a few
+// relaxed loads and stores. A snapshot taken concurrently with record() can
+// be off by the values being recorded.
+class LatencyHistogram {
+ public:
+  void record(uint64_t ns) {
+    bump(buckets_[static_cast<size_t>(HistogramBuckets::indexOf(ns))], 1);
+    bump(sum_, ns);
+    if (ns > max_.load(std::memory_order_relaxed)) {
+      max_.store(ns, std::memory_order_relaxed);
+    }
+  }
+
+  HistogramSnapshot snapshot() const;
+  // Replaces the contents; for republishing a histogram gathered elsewhere.
+  void assign(const HistogramSnapshot& snapshot);
+
+ private:
+  // Only one thread writes, so no read-modify-write is needed.
+  static void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<uint64_t>, HistogramBuckets::kCount> buckets_{};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+// The logger's own metrics, as returned by Backend::stats(). Counters are
+// totals since the backend started, including threads that have exited.
+struct LogStats {
+  // Records the backend has written to the sinks.
+  uint64_t records = 0;
+  // Records producers dropped because their ring was full, per level.
+  std::array<uint64_t, kNumLevels> dropped{};
+  // Records rate-limited statements held back (LOG_EVERY_N and friends).
+  uint64_t suppressed = 0;
+  // Most bytes the backend has found waiting in a single thread's ring.
+  size_t queueHighWater = 0;
+  // Time a log statement took from taking its timestamp to publishing the
+  // record, waits for a full ring included. Only with
+  // BackendOptions::timingStats.
+  HistogramSnapshot enqueueLatency;
+  // Time the backend took to format a record as text. Only with
+  // BackendOptions::timingStats.
+  HistogramSnapshot formatTime;
+  // Time the backend spent in each pass that flushed the sinks.
+  HistogramSnapshot flushLatency;
+  // Bytes written per sink, in the order the sinks were added; with a
+  // backend thread per NUMA node, node by node.
+  std::vector<uint64_t> sinkBytes;
+};
+
+namespace detail {
+
+// Nanoseconds per rawTimestamp() tick for producers timing their log
+// statements, or 0 while enqueue timing is off or the clock is not yet
+// calibrated. Published by the backend.
+extern std::atomic<double> gEnqueueNsPerTick;
+
+}  // namespace detail
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_STATS_H
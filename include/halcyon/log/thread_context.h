@@ -0,0 +1,167 @@
+#ifndef HALCYON_LOG_THREAD_CONTEXT_H
+#define HALCYON_LOG_THREAD_CONTEXT_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "halcyon/log/level.h"
+#include "halcyon/log/overflow_policy.h"
+#include "halcyon/log/platform.h"
+#include "halcyon/log/spsc_ring.h"
+#include "halcyon/log/stats.h"
+
+namespace halcyon::log {
+
+// Per-producer-thread state: the staging ring the thread logs into. Created
+// lazily on the thread's first log statement and owned by the registry so
+// that the backend can finish draining it after the thread has exited.
+class ThreadContext {
+ public:
+  // The ring runs on `ringBuffer`, of `ringCapacity` bytes. `node` is the
+  // NUMA node whose backend thread drains it, or kAnyNode.
+  ThreadContext(uint32_t threadId, int node, std::unique_ptr<char[]> ringBuffer,
+                size_t ringCapacity)
+      : threadId_(threadId), node_(node), ring_(std::move(ringBuffer), ringCapacity) {}
+
+  static constexpr int kAnyNode = -1;
+
+  uint32_t threadId() const { return threadId_; }
+  int node() const { return node_; }
+  SpscRing& ring() { return ring_; }
+
+  // Producer: returns room for a `size` byte record of `level`. If the ring
+  // is full, `policy` decides between waiting for the backend, discarding
+  // older records, and returning nullptr to drop this one. Records larger
+  // than ring().maxRecordSize() must be truncated by the caller.
+  char* prepareWrite(size_t size, OverflowPolicy policy, Level level) {
+    if (HALCYON_LOG_UNLIKELY(policy == OverflowPolicy::kOverwriteOldest && !overwriteRequested_)) {
+      // Ask early, so the backend has switched modes by the time it matters.
+      overwriteRequested_ = true;
+      ring_.requestOverwrite();
+    }
+    char* p = ring_.prepareWrite(size);
+    return HALCYON_LOG_LIKELY(p != nullptr) ? p : makeRoom(size, policy, level);
+  }
+
+  void commitWrite(size_t size) { ring_.commitWrite(size); }
+
+  // Set by the owning thread on exit; the backend reclaims the context once
+  // its ring is empty.
+  bool retired() const { return retired_.load(std::memory_order_acquire); }
+  void retire() { retired_.store(true, std::memory_order_release); }
+
+  // Records of `level` this thread dropped because its ring was full.
+  uint64_t dropped(Level level) const {
+    return dropped_[static_cast<size_t>(level)].load(std::memory_order_relaxed);
+  }
+
+  // Producer: times a log statement, see LogStats::enqueueLatency.
+  void recordEnqueueLatency(uint64_t ns) { enqueueLatency_.record(ns); }
+
+  // Backend: notes how many bytes it found waiting in the ring.
+  void noteQueueDepth(size_t bytes) {
+    if (bytes > queueHighWater_.load(std::memory_order_relaxed)) {
+      queueHighWater_.store(bytes, std::memory_order_relaxed);
+    }
+  }
+
+  // Adds this thread's drops, queue high-water mark and enqueue latencies.
+  void addStats(LogStats& stats) const;
+
+  // Returns the calling thread's context, creating and registering it on
+  // first use.
+  static ThreadContext& local();
+
+ private:
+  HALCYON_LOG_NOINLINE char* makeRoom(size_t size, OverflowPolicy policy, Level level);
+
+  // Only the owning thread counts, so no read-modify-write is needed.
+  void countDrop(Level level) {
+    auto& counter = dropped_[static_cast<size_t>(level)];
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  const uint32_t threadId_;
+  const int node_;
+  SpscRing ring_;
+  std::atomic<bool> retired_{false};
+  bool overwriteRequested_ = false;
+  std::array<std::atomic<uint64_t>, kNumLevels> dropped_{};
+  LatencyHistogram enqueueLatency_;
+  std::atomic<size_t> queueHighWater_{0};
+};
+
+// Keeps track of every live ThreadContext. Producers only take the lock when
+// a thread logs for the first time; the backend only takes it when the set
+// of contexts has changed.
+//
+// The ring buffers of reclaimed contexts are kept, up to kMaxSpareRings, and
+// given to the next threads that start logging, so that a thread pool that
+// replaces its threads does not allocate (and fault in) a fresh ring for
+// each of them.
+//
+// When the backend drains per NUMA node (setNodes()), each context belongs to
+// the node its thread was running on when it first logged, and its ring is
+// placed on that node.
+class ThreadContextRegistry {
+ public:
+  static ThreadContextRegistry& instance();
+
+  // Ring size for contexts created from now on; rounded up to a power of two.
+  void setRingCapacity(size_t bytes);
+
+  // Nodes the backend drains separately, each on its own thread; a thread
+  // that starts logging on any other node goes with the first of them.
+  // Empty, the default, puts every context on ThreadContext::kAnyNode.
+  void setNodes(std::vector<int> nodes);
+
+  std::shared_ptr<ThreadContext> create(uint32_t threadId);
+
+  // Backend: refreshes `contexts` with those of `node` (all of them for
+  // kAnyNode) if threads were created or reclaimed since the call that
+  // returned `version`.
+  void snapshot(std::vector<std::shared_ptr<ThreadContext>>& contexts, uint64_t& version,
+                int node = ThreadContext::kAnyNode);
+
+  // Backend: drops retired contexts of `node` whose rings have been fully
+  // drained. Returns true if anything was removed.
+  bool reclaim(int node = ThreadContext::kAnyNode);
+
+  // Records dropped so far by all threads, including exited ones, per level.
+  std::array<uint64_t, kNumLevels> droppedRecords();
+
+  // Adds the producer side statistics of all threads, including exited
+  // ones, to `stats`.
+  void collectStats(LogStats& stats);
+
+ private:
+  static constexpr size_t kMaxSpareRings = 16;
+
+  struct SpareRing {
+    std::unique_ptr<char[]> buffer;
+    int node;
+  };
+
+  ThreadContextRegistry() = default;
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<ThreadContext>> contexts_;
+  std::vector<int> nodes_;
+  // Producer statistics of the contexts reclaimed so far.
+  LogStats reclaimed_;
+  // Buffers of reclaimed rings, all of spareRingCapacity_ bytes.
+  std::vector<SpareRing> spareRings_;
+  size_t spareRingCapacity_ = 0;
+  std::atomic<size_t> ringCapacity_{256 * 1024};
+  std::atomic<uint64_t> version_{0};
+};
+
+}  // namespace halcyon::log
+
+#endif  // HALCYON_LOG_THREAD_CONTEXT_H
@@ -0,0 +1,100 @@
+#include "halcyon/log/async_sink.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace halcyon::log {
+
+AsyncSink::AsyncSink(std::shared_ptr<Sink> sink, size_t capacity,
+                     std::chrono::milliseconds flushTimeout)
+    : sink_(std::move(sink)), capacity_(capacity), flushTimeout_(flushTimeout) {
+  if (!sink_->wantsText()) {
+    throw std::invalid_argument("halcyon_log: AsyncSink only wraps text sinks");
+  }
+  thread_ = std::thread([this] { run(); });
+}
+
+AsyncSink::~AsyncSink() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+void AsyncSink::write(std::string_view line) {
+  bool wasEmpty;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.size() + line.size() > capacity_) {
+      droppedLines_.store(droppedLines_.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+      return;
+    }
+    wasEmpty = pending_.empty();
+    pending_.append(line);
+  }
+  // The thread only sleeps with nothing pending, so it needs waking once
+  // per batch rather than per line.
+  if (wasEmpty) {
+    wake_.notify_one();
+  }
+}
+
+void AsyncSink::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t target = ++flushRequested_;
+  wake_.notify_one();
+  // A sink that already missed a flush is presumably still stuck in it.
+  auto timeout = flushCompleted_ < flushAbandoned_ ? std::chrono::milliseconds(0) : flushTimeout_;
+  if (!flushed_.wait_for(lock, timeout, [&] { return flushCompleted_ >= target; })) {
+    flushAbandoned_ = target;
+    dropPending();
+  }
+}
+
+void AsyncSink::dropPending() {
+  auto lines = static_cast<uint64_t>(std::count(pending_.begin(), pending_.end(), '\n'));
+  pending_.clear();
+  droppedLines_.store(droppedLines_.load(std::memory_order_relaxed) + lines,
+                      std::memory_order_relaxed);
+}
+
+// Lines are handed on as soon as they arrive; there is nothing to start.
+void AsyncSink::flushAsync() {}
+
+void AsyncSink::run() {
+  // Swapped with pending_, so both keep their capacity.
+  std::string batch;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_.wait(lock, [this] {
+      return stopping_ || !pending_.empty() || flushRequested_ != flushCompleted_;
+    });
+    uint64_t requested = flushRequested_;
+    bool stopping = stopping_;
+    batch.swap(pending_);
+    lock.unlock();
+
+    if (!batch.empty()) {
+      sink_->write(batch);
+      batch.clear();
+    }
+    if (requested != flushCompleted_ || stopping) {
+      sink_->flush();
+    }
+
+    lock.lock();
+    if (requested != flushCompleted_) {
+      flushCompleted_ = requested;
+      flushed_.notify_all();
+    }
+    if (stopping && pending_.empty()) {
+      break;
+    }
+  }
+}
+
+}  // namespace halcyon::log
@@ -0,0 +1,581 @@
+#include "halcyon/log/backend.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#include "halcyon/log/numa.h"
+
+namespace halcyon::log {
+
+namespace {
+
+// FATAL records always block, so they are never dropped.
+constexpr char kDropFormat[] =
+    "{} records dropped since the last report (TRACE {}, DEBUG {}, INFO {}, WARN {}, ERROR {})";
+using DropArgTypes =
+    detail::ArgTypeList<uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t>;
+constexpr auto kDropSegments =
+    detail::compileFormat<detail::countSegments(kDropFormat), DropArgTypes>(kDropFormat);
+constinit CallSite gDropSite{__FILE__,
+                             "halcyon_log",
+                             __LINE__,
+                             Level::kWarn,
+                             kDropFormat,
+                             kDropSegments.data(),
+                             static_cast<uint32_t>(kDropSegments.size()),
+                             DropArgTypes::kTypes.data(),
+                             static_cast<uint32_t>(DropArgTypes::kTypes.size())};
+
+constexpr char kSuppressedFormat[] = "{} records suppressed at {}:{} since the last report";
+using SuppressedArgs = detail::ArgTypeList<uint64_t, std::string_view, uint32_t>;
+constexpr auto kSuppressedSegments =
+    detail::compileFormat<detail::countSegments(kSuppressedFormat), SuppressedArgs>(
+        kSuppressedFormat);
+constinit CallSite gSuppressedSite{__FILE__,
+                                   "halcyon_log",
+                                   __LINE__,
+                                   Level::kInfo,
+                                   kSuppressedFormat,
+                                   kSuppressedSegments.data(),
+                                   static_cast<uint32_t>(kSuppressedSegments.size()),
+                                   SuppressedArgs::kTypes.data(),
+                                   static_cast<uint32_t>(SuppressedArgs::kTypes.size())};
+
+constexpr char kRepeatFormat[] = "last message repeated {} times";
+using RepeatArgTypes = detail::ArgTypeList<uint64_t>;
+constexpr auto kRepeatSegments =
+    detail::compileFormat<detail::countSegments(kRepeatFormat), RepeatArgTypes>(kRepeatFormat);
+
+constexpr CallSite repeatSite(Level level) {
+  return CallSite{__FILE__,
+                  "halcyon_log",
+                  __LINE__,
+                  level,
+                  kRepeatFormat,
+                  kRepeatSegments.data(),
+                  static_cast<uint32_t>(kRepeatSegments.size()),
+                  RepeatArgTypes::kTypes.data(),
+                  static_cast<uint32_t>(RepeatArgTypes::kTypes.size())};
+}
+
+// One per level, so that the summary of a run has the level of its records.
+constinit CallSite gRepeatSites[kNumLevels] = {
+    repeatSite(Level::kTrace), repeatSite(Level::kDebug), repeatSite(Level::kInfo),
+    repeatSite(Level::kWarn),  repeatSite(Level::kError), repeatSite(Level::kFatal),
+};
+
+// Hash of a record's argument bytes, eight at a time, each folded in with
+// a 64x64->128 bit multiply.
+uint64_t hashBytes(std::string_view bytes) {
+  constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ULL;
+  auto mix = [](uint64_t a, uint64_t b) {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+  };
+  uint64_t hash = bytes.size();
+  const char* p = bytes.data();
+  size_t n = bytes.size();
+  for (; n >= 8; p += 8, n -= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, 8);
+    hash = mix(hash ^ word, kMultiplier);
+  }
+  if (n != 0) {
+    uint64_t word = 0;
+    std::memcpy(&word, p, n);
+    hash = mix(hash ^ word, kMultiplier);
+  }
+  return mix(hash, kMultiplier ^ 0xFF51AFD7ED558CCDULL);
+}
+
+constexpr char kStatsFormat[] =
+    "{} records, {} dropped, queue high-water {} bytes, enqueue p50 {} p99 {} max {} ns, "
+    "format p50 {} p99 {} max {} ns, flush p50 {} p99 {} max {} ns, sink bytes [{}]";
+template <template <typename...> class T>
+using WithStatsArgs = T<uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+                        uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, std::string_view>;
+using StatsArgTypes = WithStatsArgs<detail::ArgTypeList>;
+using StatsEncoder = WithStatsArgs<detail::ArgEncoder>;
+constexpr auto kStatsSegments =
+    detail::compileFormat<detail::countSegments(kStatsFormat), StatsArgTypes>(kStatsFormat);
+constinit CallSite gStatsSite{__FILE__,
+                              "halcyon_log",
+                              __LINE__,
+                              Level::kInfo,
+                              kStatsFormat,
+                              kStatsSegments.data(),
+                              static_cast<uint32_t>(kStatsSegments.size()),
+                              StatsArgTypes::kTypes.data(),
+                              static_cast<uint32_t>(StatsArgTypes::kTypes.size())};
+
+// How often the producer side statistics are gathered for stats().
+constexpr std::chrono::milliseconds kStatsPublishInterval{100};
+
+}  // namespace
+
+Backend& Backend::instance() {
+  static Backend backend;
+  return backend;
+}
+
+Backend::Backend() {
+  // Construct the registries first so they outlive the backend during static
+  // destruction, when stop() drains the remaining records.
+  ThreadContextRegistry::instance();
+  CallSiteRegistry::instance();
+}
+
+Backend::~Backend() { stop(); }
+
+void Backend::start(const BackendOptions& options) {
+  std::call_once(startOnce_, [this, &options] {
+    options_ = options;
+    ThreadContextRegistry::instance().setRingCapacity(options_.ringCapacity);
+    TimestampConverter::select(options_.clockSource);
+
+    std::vector<NumaNode> nodes;
+    if (options_.numaSinks) {
+      nodes = numaNodes();
+    }
+    std::vector<std::unique_ptr<Shard>> shards;
+    if (nodes.size() > 1) {
+      for (NumaNode& node : nodes) {
+        auto shard = std::make_unique<Shard>();
+        shard->node = node.id;
+        shard->cpus = std::move(node.cpus);
+        shard->sinks = options_.numaSinks(node.id);
+        shards.push_back(std::move(shard));
+      }
+    } else {
+      shards.push_back(std::make_unique<Shard>());
+      if (options_.numaSinks) {
+        shards.front()->sinks = options_.numaSinks(nodes.empty() ? 0 : nodes.front().id);
+      }
+    }
+    auto& firstSinks = shards.front()->sinks;
+    firstSinks.insert(firstSinks.begin(), sinks_.begin(), sinks_.end());
+    for (auto& shard : shards) {
+      for (size_t layout = 0; layout < kNumLayouts; ++layout) {
+        shard->formatters[layout] = Formatter(static_cast<Layout>(layout));
+      }
+      if (shard->sinks.empty()) {
+        shard->sinks.push_back(std::make_shared<ConsoleSink>());
+      }
+      for (auto& sink : shard->sinks) {
+        shard->sinkLayouts.push_back(sink->layout().value_or(options_.layout));
+      }
+    }
+    shards_ = std::move(shards);
+    if (shards_.size() > 1) {
+      std::vector<int> ids;
+      for (const auto& shard : shards_) {
+        ids.push_back(shard->node);
+      }
+      ThreadContextRegistry::instance().setNodes(std::move(ids));
+    }
+
+    running_.store(true, std::memory_order_release);
+    for (auto& shard : shards_) {
+      shard->thread = std::thread([this, shard = shard.get()] {
+        // Before the thread allocates anything, so that it does on its node.
+        if (!shard->cpus.empty()) {
+          pinCurrentThread(shard->cpus);
+        }
+        run(*shard);
+      });
+    }
+  });
+}
+
+void Backend::stop() {
+  if (!running_.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  for (auto& shard : shards_) {
+    shard->thread.join();
+  }
+}
+
+void Backend::addSink(std::shared_ptr<Sink> sink) {
+  if (running_.load(std::memory_order_acquire)) {
+    throw std::logic_error("halcyon_log: sinks must be added before the backend starts");
+  }
+  sinks_.push_back(std::move(sink));
+}
+
+void Backend::flush() {
+  ensureStarted();
+  uint64_t ticket = flushRequested_.fetch_add(1, std::memory_order_acq_rel) + 1;
+  for (const auto& shard : shards_) {
+    while (shard->flushCompleted.load(std::memory_order_acquire) < ticket) {
+      if (!running_.load(std::memory_order_acquire)) {
+        return;
+      }
+      std::this_thread::sleep_for(options_.idleSleep);
+    }
+  }
+}
+
+LogStats Backend::stats() const {
+  LogStats stats;
+  for (int level = 0; level < kNumLevels; ++level) {
+    stats.dropped[level] = dropped_[level].load(std::memory_order_relaxed);
+  }
+  stats.queueHighWater = queueHighWater_.load(std::memory_order_relaxed);
+  stats.enqueueLatency = enqueueLatency_.snapshot();
+  for (const SiteLimiter* limiter = SiteLimiter::first(); limiter != nullptr;
+       limiter = limiter->next()) {
+    stats.suppressed += limiter->suppressed();
+  }
+  for (const auto& shard : shards_) {
+    stats.records += shard->records.load(std::memory_order_relaxed);
+    stats.formatTime.merge(shard->formatTime.snapshot());
+    stats.flushLatency.merge(shard->flushLatency.snapshot());
+    for (const auto& sink : shard->sinks) {
+      stats.sinkBytes.push_back(sink->bytesWritten());
+    }
+  }
+  return stats;
+}
+
+void Backend::run(Shard& shard) {
+  using Clock = std::chrono::steady_clock;
+  bool primary = isPrimary(shard);
+  auto publishTickRate = [this, &shard, primary] {
+    if (primary && options_.timingStats) {
+      detail::gEnqueueNsPerTick.store(shard.clock.nsPerTick(), std::memory_order_relaxed);
+    }
+  };
+  // Producers may already be logging raw ticks; they simply wait in their
+  // rings until the initial calibration is done.
+  shard.clock.calibrate();
+  publishTickRate();
+  auto lastFlush = Clock::now();
+  auto lastCalibration = lastFlush;
+  auto lastDropReport = lastFlush;
+  auto lastStatsPublish = lastFlush;
+  auto lastStatsReport = lastFlush;
+  for (;;) {
+    // Sample the flag before draining so that a stop() racing with the last
+    // enqueue still sees those records written.
+    bool running = running_.load(std::memory_order_acquire);
+    size_t drained = drainAll(shard);
+
+    uint64_t requested = flushRequested_.load(std::memory_order_acquire);
+    auto now = Clock::now();
+    if (now - lastCalibration >= options_.calibrationInterval) {
+      shard.clock.recalibrate();
+      publishTickRate();
+      lastCalibration = now;
+    }
+    if (primary && (!running || now - lastDropReport >= options_.dropReportInterval)) {
+      reportDrops();
+      reportSuppressed();
+      lastDropReport = now;
+    }
+    if (primary && options_.statsInterval.count() != 0 &&
+        now - lastStatsReport >= options_.statsInterval) {
+      reportStats();
+      lastStatsReport = now;
+    }
+    if (primary && now - lastStatsPublish >= kStatsPublishInterval) {
+      publishStats();
+      lastStatsPublish = now;
+    }
+    // Sinks are not flushed merely because the backend went idle: under a
+    // steady trickle of records that would turn every drain pass into a
+    // write() of a few lines. File sinks batch on their own and flush on
+    // their own timer. Only stop() and flush requests wait for the sinks;
+    // the periodic flush just hands buffered data on.
+    bool wait = !running || requested != shard.flushCompleted.load(std::memory_order_relaxed);
+    if (wait || now - lastFlush >= options_.flushInterval) {
+      // Everything enqueued before the flush requests were made is drained
+      // once a drain pass comes back empty.
+      while (drainAll(shard) != 0) {
+      }
+      reportRepeats(shard);
+      flushSinks(shard, wait);
+      if (wait && primary) {
+        publishStats();
+      }
+      shard.flushCompleted.store(requested, std::memory_order_release);
+      lastFlush = now;
+    }
+
+    if (!running) {
+      break;
+    }
+    if (drained == 0) {
+      std::this_thread::sleep_for(options_.idleSleep);
+    }
+  }
+}
+
+size_t Backend::drainAll(Shard& shard) {
+  ThreadContextRegistry& registry = ThreadContextRegistry::instance();
+  if (shard.reclaimPending) {
+    shard.reclaimPending = false;
+    registry.reclaim(shard.node);
+  }
+  registry.snapshot(shard.contexts, shard.contextsVersion, shard.node);
+
+  size_t count = 0;
+  for (auto& context : shard.contexts) {
+    count += drain(shard, *context);
+  }
+  if (count != 0) {
+    shard.dirty = true;
+    shard.unflushed = true;
+  }
+  return count;
+}
+
+size_t Backend::drain(Shard& shard, ThreadContext& context) {
+  // Bound the batch taken from one ring so that a single busy thread cannot
+  // starve the others, and so that flush requests and the flush interval are
+  // serviced under sustained load.
+  constexpr size_t kMaxBatch = 256;
+  const CallSiteRegistry& sites = CallSiteRegistry::instance();
+  SpscRing& ring = context.ring();
+  Record record;
+  record.threadId = context.threadId();
+  context.noteQueueDepth(ring.size());
+  size_t count = 0;
+  for (; count < kMaxBatch; ++count) {
+    const char* data = ring.prepareRead();
+    if (data == nullptr) {
+      if (context.retired()) {
+        shard.reclaimPending = true;
+      }
+      break;
+    }
+    RecordHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    record.timestamp = shard.clock.toNanoseconds(header.timestamp);
+    record.siteId = header.siteId;
+    record.site = sites.find(header.siteId);
+    record.args = std::string_view(data + sizeof(header), header.size - sizeof(header));
+
+    if (!options_.collapseDuplicates || !collapse(shard, record)) {
+      dispatch(shard, record);
+    }
+    ring.finishRead(header.size);
+  }
+  return count;
+}
+
+void Backend::dispatch(Shard& shard, const Record& record) {
+  Level level = record.site->level;
+  // Each layout is formatted at most once, for the first sink that takes
+  // the record in it.
+  unsigned formatted = 0;
+  for (size_t i = 0; i < shard.sinks.size(); ++i) {
+    Sink& sink = *shard.sinks[i];
+    if (level < sink.level()) {
+      continue;
+    }
+    if (!sink.wantsText()) {
+      sink.writeRecord(record);
+      continue;
+    }
+    auto layout = static_cast<size_t>(shard.sinkLayouts[i]);
+    std::string& line = shard.lines[layout];
+    if ((formatted & (1u << layout)) == 0) {
+      formatted |= 1u << layout;
+      line.clear();
+      if (options_.timingStats) {
+        uint64_t start = rawTimestamp();
+        shard.formatters[layout].format(record, line);
+        auto ticks = static_cast<double>(rawTimestamp() - start);
+        shard.formatTime.record(static_cast<uint64_t>(ticks * shard.clock.nsPerTick()));
+      } else {
+        shard.formatters[layout].format(record, line);
+      }
+    }
+    sink.write(line);
+    sink.addBytesWritten(line.size());
+  }
+  shard.records.store(shard.records.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+}
+
+// Whether `record` repeats the one before it, in which case it is only
+// counted. The arguments are compared by a 64-bit hash rather than byte by
+// byte, which would mean keeping a copy of every record: a false match takes
+// a hash collision between consecutive records of the same call site.
+bool Backend::collapse(Shard& shard, const Record& record) {
+  uint64_t hash = hashBytes(record.args);
+  if (record.siteId == shard.lastSiteId && hash == shard.lastArgsHash) {
+    ++shard.repeats;
+    shard.lastRepeat = record.timestamp;
+    return true;
+  }
+  reportRepeats(shard);
+  shard.lastSiteId = record.siteId;
+  shard.lastArgsHash = hash;
+  shard.lastLevel = record.site != nullptr ? record.site->level : Level::kInfo;
+  return false;
+}
+
+// Ends the current run of duplicates, if any, with a line counting them,
+// timestamped like the last of them.
+void Backend::reportRepeats(Shard& shard) {
+  if (shard.repeats == 0) {
+    return;
+  }
+  char args[sizeof(uint64_t)];
+  detail::ArgEncoder<uint64_t> encoder;
+  encoder.size(shard.repeats);
+  char* end = encoder.encode(args, shard.repeats);
+  shard.repeats = 0;
+
+  CallSite& site = gRepeatSites[std::min(static_cast<int>(shard.lastLevel), kNumLevels - 1)];
+  Record record;
+  record.timestamp = shard.lastRepeat;
+  record.threadId = currentThreadId();
+  record.siteId = site.id();
+  record.site = &site;
+  record.args = std::string_view(args, static_cast<size_t>(end - args));
+  dispatch(shard, record);
+  shard.dirty = true;
+  shard.unflushed = true;
+}
+
+// Logs how many records producers dropped since the last report, as a WARN
+// record of the backend's own call site.
+void Backend::reportDrops() {
+  std::array<uint64_t, kNumLevels> counts = ThreadContextRegistry::instance().droppedRecords();
+  uint64_t delta[kNumLevels];
+  uint64_t total = 0;
+  for (int level = 0; level < kNumLevels; ++level) {
+    delta[level] = counts[level] - reportedDrops_[level];
+    total += delta[level];
+  }
+  if (total == 0) {
+    return;
+  }
+  reportedDrops_ = counts;
+
+  using Encoder = detail::ArgEncoder<uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t>;
+  char args[6 * sizeof(uint64_t)];
+  Encoder encoder;
+  encoder.size(total, delta[0], delta[1], delta[2], delta[3], delta[4]);
+  char* end = encoder.encode(args, total, delta[0], delta[1], delta[2], delta[3], delta[4]);
+
+  Record record;
+  record.timestamp = static_cast<int64_t>(detail::systemNanoseconds());
+  record.threadId = currentThreadId();
+  record.siteId = gDropSite.id();
+  record.site = &gDropSite;
+  record.args = std::string_view(args, static_cast<size_t>(end - args));
+  report(record);
+}
+
+// Logs, per rate-limited statement, how many records its limiter held back
+// since the last report, as INFO records of the backend's own call site.
+void Backend::reportSuppressed() {
+  for (SiteLimiter* limiter = SiteLimiter::first(); limiter != nullptr;
+       limiter = limiter->next()) {
+    uint64_t count = limiter->suppressed();
+    uint64_t delta = count - limiter->reported_;
+    if (delta == 0) {
+      continue;
+    }
+    limiter->reported_ = count;
+
+    const CallSite& site = *limiter->site();
+    const char* slash = std::strrchr(site.file, '/');
+    std::string_view file = slash ? slash + 1 : site.file;
+    detail::ArgEncoder<uint64_t, std::string_view, uint32_t> encoder;
+    std::string args(encoder.size(delta, file, site.line), '\0');
+    char* end = encoder.encode(args.data(), delta, file, site.line);
+
+    Record record;
+    record.timestamp = static_cast<int64_t>(detail::systemNanoseconds());
+    record.threadId = currentThreadId();
+    record.siteId = gSuppressedSite.id();
+    record.site = &gSuppressedSite;
+    record.args = std::string_view(args.data(), static_cast<size_t>(end - args.data()));
+    report(record);
+  }
+}
+
+// Makes the producer side statistics visible to stats().
+void Backend::publishStats() {
+  LogStats stats;
+  ThreadContextRegistry::instance().collectStats(stats);
+  for (int level = 0; level < kNumLevels; ++level) {
+    dropped_[level].store(stats.dropped[level], std::memory_order_relaxed);
+  }
+  queueHighWater_.store(stats.queueHighWater, std::memory_order_relaxed);
+  enqueueLatency_.assign(stats.enqueueLatency);
+}
+
+// Logs the statistics as an INFO record of the backend's own call site.
+void Backend::reportStats() {
+  publishStats();
+  LogStats stats = this->stats();
+  uint64_t dropped = 0;
+  for (uint64_t count : stats.dropped) {
+    dropped += count;
+  }
+  std::string sinkBytes;
+  for (uint64_t bytes : stats.sinkBytes) {
+    if (!sinkBytes.empty()) {
+      sinkBytes += ' ';
+    }
+    sinkBytes += std::to_string(bytes);
+  }
+  const HistogramSnapshot& enqueue = stats.enqueueLatency;
+  const HistogramSnapshot& format = stats.formatTime;
+  const HistogramSnapshot& flush = stats.flushLatency;
+  auto values = std::make_tuple(
+      stats.records, dropped, uint64_t{stats.queueHighWater}, enqueue.percentile(0.5),
+      enqueue.percentile(0.99), enqueue.max, format.percentile(0.5), format.percentile(0.99),
+      format.max, flush.percentile(0.5), flush.percentile(0.99), flush.max,
+      std::string_view(sinkBytes));
+  StatsEncoder encoder;
+  std::string args(std::apply([&](const auto&... v) { return encoder.size(v...); }, values), '\0');
+  char* end =
+      std::apply([&](const auto&... v) { return encoder.encode(args.data(), v...); }, values);
+
+  Record record;
+  record.timestamp = static_cast<int64_t>(detail::systemNanoseconds());
+  record.threadId = currentThreadId();
+  record.siteId = gStatsSite.id();
+  record.site = &gStatsSite;
+  record.args = std::string_view(args.data(), static_cast<size_t>(end - args.data()));
+  report(record);
+}
+
+void Backend::report(const Record& record) {
+  Shard& shard = *shards_.front();
+  dispatch(shard, record);
+  shard.dirty = true;
+  shard.unflushed = true;
+}
+
+void Backend::flushSinks(Shard& shard, bool wait) {
+  if (!(wait ? shard.unflushed : shard.dirty)) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (auto& sink : shard.sinks) {
+    if (wait) {
+      sink->flush();
+    } else {
+      sink->flushAsync();
+    }
+  }
+  shard.flushLatency.record(static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+          .count()));
+  shard.dirty = false;
+  shard.unflushed = shard.unflushed && !wait;
+}
+
+}  // namespace halcyon::log
@@ -0,0 +1,318 @@
+#include "halcyon/log/binary_format.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace halcyon::log::binary {
+
+namespace {
+
+// The most ids the registry hands out; a larger one means a corrupt file,
+// and the decoder would otherwise size its site table by it.
+constexpr uint64_t kMaxSiteId =
+    uint64_t{CallSiteRegistry::kChunkSize} * CallSiteRegistry::kMaxChunks;
+
+void putString(std::string& out, std::string_view s) {
+  putVarint(out, s.size());
+  out.append(s);
+}
+
+}  // namespace
+
+void Encoder::writeHeader(std::string& out, int64_t baseTimestamp) {
+  out.append(kMagic, sizeof(kMagic));
+  out.push_back(static_cast<char>(kVersion));
+  putVarint(out, zigzagEncode(baseTimestamp));
+  lastTimestamp_ = baseTimestamp;
+
+  const CallSiteRegistry& registry = CallSiteRegistry::instance();
+  uint32_t count = registry.size();
+  putVarint(out, count);
+  writtenSites_.assign(count + 1, false);
+  for (uint32_t id = 1; id <= count; ++id) {
+    writeSite(out, id, *registry.find(id));
+  }
+}
+
+void Encoder::writeSite(std::string& out, uint32_t id, const CallSite& site) {
+  putVarint(out, id);
+  putVarint(out, site.line);
+  out.push_back(static_cast<char>(static_cast<uint8_t>(site.level) |
+                                  (site.structured ? kStructuredFlag : 0)));
+  putVarint(out, site.argCount);
+  out.append(reinterpret_cast<const char*>(site.argTypes), site.argCount);
+  putString(out, site.file);
+  putString(out, site.function);
+  putString(out, site.format);
+  if (writtenSites_.size() <= id) {
+    writtenSites_.resize(id + 1, false);
+  }
+  writtenSites_[id] = true;
+}
+
+void Encoder::writeRecord(std::string& out, const Record& record) {
+  const CallSite& site = *record.site;
+  if (record.siteId >= writtenSites_.size() || !writtenSites_[record.siteId]) {
+    out.push_back(static_cast<char>(kSiteFrame));
+    writeSite(out, record.siteId, site);
+  }
+
+  out.push_back(static_cast<char>(kRecordFrame));
+  putVarint(out, record.siteId);
+  putVarint(out, zigzagEncode(record.timestamp - lastTimestamp_));
+  lastTimestamp_ = record.timestamp;
+  putVarint(out, record.threadId);
+
+  ArgReader reader(record.args);
+  for (uint32_t i = 0; i < site.argCount; ++i) {
+    switch (site.argTypes[i]) {
+      case ArgType::kBool:
+      case ArgType::kChar:
+        out.push_back(reader.read<char>());
+        break;
+      case ArgType::kInt32:
+        putVarint(out, zigzagEncode(reader.read<int32_t>()));
+        break;
+      case ArgType::kUint32:
+        putVarint(out, reader.read<uint32_t>());
+        break;
+      case ArgType::kInt64:
+        putVarint(out, zigzagEncode(reader.read<int64_t>()));
+        break;
+      case ArgType::kUint64:
+      case ArgType::kPointer:
+        putVarint(out, reader.read<uint64_t>());
+        break;
+      case ArgType::kDouble: {
+        double v = reader.read<double>();
+        out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+        break;
+      }
+      case ArgType::kString:
+        putString(out, reader.readString());
+        break;
+    }
+  }
+}
+
+// A call site rebuilt from its definition. The strings and tables are owned
+// here because CallSite only points at them.
+struct Decoder::Site {
+  std::string file;
+  std::string function;
+  std::string format;
+  std::vector<ArgType> argTypes;
+  std::vector<FormatSegment> segments;
+  std::unique_ptr<CallSite> callSite;
+};
+
+Decoder::Decoder(std::string_view data) : p_(data.data()), end_(data.data() + data.size()) {}
+
+Decoder::~Decoder() = default;
+
+bool Decoder::readHeader() {
+  if (static_cast<size_t>(end_ - p_) < sizeof(kMagic) + 1 ||
+      std::memcmp(p_, kMagic, sizeof(kMagic)) != 0) {
+    error_ = "not a halcyon_log binary file";
+    return false;
+  }
+  p_ += sizeof(kMagic);
+  if (static_cast<uint8_t>(*p_++) != kVersion) {
+    error_ = "unsupported version";
+    return false;
+  }
+  uint64_t base, count;
+  if (!getVarint(p_, end_, base) || !getVarint(p_, end_, count)) {
+    error_ = "truncated header";
+    return false;
+  }
+  lastTimestamp_ = zigzagDecode(base);
+  for (uint64_t i = 0; i < count; ++i) {
+    if (!readSite()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Decoder::readString(std::string& s) {
+  uint64_t length;
+  if (!getVarint(p_, end_, length) || length > static_cast<uint64_t>(end_ - p_)) {
+    return false;
+  }
+  s.assign(p_, length);
+  p_ += length;
+  return true;
+}
+
+bool Decoder::readSite() {
+  auto site = std::make_unique<Site>();
+  uint64_t id, line, argCount;
+  if (!getVarint(p_, end_, id) || id == 0 || id > UINT32_MAX || !getVarint(p_, end_, line) ||
+      p_ >= end_) {
+    error_ = "truncated site definition";
+    return false;
+  }
+  if (id > kMaxSiteId) {
+    error_ = "bad site id";
+    return false;
+  }
+  uint8_t level = static_cast<uint8_t>(*p_++);
+  bool structured = (level & kStructuredFlag) != 0;
+  level &= static_cast<uint8_t>(~kStructuredFlag);
+  if (level > static_cast<uint8_t>(Level::kOff) || !getVarint(p_, end_, argCount) ||
+      argCount > static_cast<uint64_t>(end_ - p_)) {
+    error_ = "corrupt site definition";
+    return false;
+  }
+  for (uint64_t i = 0; i < argCount; ++i) {
+    uint8_t type = static_cast<uint8_t>(*p_++);
+    if (type > static_cast<uint8_t>(ArgType::kString)) {
+      error_ = "unknown argument type";
+      return false;
+    }
+    site->argTypes.push_back(static_cast<ArgType>(type));
+  }
+  if (!readString(site->file) || !readString(site->function) || !readString(site->format)) {
+    error_ = "truncated site definition";
+    return false;
+  }
+  // The formatter reads the fields of a structured site as key, value
+  // pairs with string keys.
+  if (structured) {
+    bool pairs = argCount % 2 == 0;
+    for (uint64_t i = 0; pairs && i < argCount; i += 2) {
+      pairs = site->argTypes[i] == ArgType::kString;
+    }
+    if (!pairs) {
+      error_ = "corrupt site definition";
+      return false;
+    }
+  }
+
+  size_t slots = 0;
+  FormatError parseError = detail::parseFormat(site->format, [&](const FormatSegment& seg) {
+    site->segments.push_back(seg);
+    slots += seg.hasArg ? 1 : 0;
+  });
+  // The fields of a structured site are not formatted through placeholders.
+  if (parseError != FormatError::kNone || slots != (structured ? 0 : argCount)) {
+    // Only possible for files from a different build; show the raw format.
+    FormatSegment literal;
+    literal.literalLength =
+        static_cast<uint16_t>(std::min<size_t>(site->format.size(), UINT16_MAX));
+    site->segments.assign(1, literal);
+  }
+
+  site->callSite = std::make_unique<CallSite>(
+      site->file.c_str(), site->function.c_str(), static_cast<uint32_t>(line),
+      static_cast<Level>(level), site->format.c_str(), site->segments.data(),
+      static_cast<uint32_t>(site->segments.size()), site->argTypes.data(),
+      static_cast<uint32_t>(site->argTypes.size()), structured);
+  if (sites_.size() <= id) {
+    sites_.resize(id + 1);
+  }
+  sites_[id] = std::move(site);
+  return true;
+}
+
+Decoder::Status Decoder::fail(const char* what) {
+  error_ = what;
+  return Status::kError;
+}
+
+Decoder::Status Decoder::next(Record& record) {
+  for (;;) {
+    if (p_ >= end_) {
+      return Status::kEnd;
+    }
+    uint8_t frame = static_cast<uint8_t>(*p_++);
+    if (frame == kSiteFrame) {
+      if (!readSite()) {
+        return Status::kError;
+      }
+      continue;
+    }
+    if (frame != kRecordFrame) {
+      return fail("unknown frame type");
+    }
+    break;
+  }
+
+  uint64_t siteId, delta, threadId;
+  if (!getVarint(p_, end_, siteId) || !getVarint(p_, end_, delta) ||
+      !getVarint(p_, end_, threadId)) {
+    return fail("truncated record");
+  }
+  if (siteId >= sites_.size() || !sites_[siteId]) {
+    return fail("record refers to an undefined call site");
+  }
+  const Site& site = *sites_[siteId];
+  lastTimestamp_ += zigzagDecode(delta);
+
+  // Re-encode the arguments in the in-memory layout the Formatter reads.
+  args_.clear();
+  for (ArgType type : site.argTypes) {
+    uint64_t v;
+    switch (type) {
+      case ArgType::kBool:
+      case ArgType::kChar:
+        if (p_ >= end_) {
+          return fail("truncated record");
+        }
+        args_.push_back(*p_++);
+        break;
+      case ArgType::kInt32:
+      case ArgType::kUint32: {
+        if (!getVarint(p_, end_, v)) {
+          return fail("truncated record");
+        }
+        uint32_t value = type == ArgType::kInt32
+                             ? static_cast<uint32_t>(zigzagDecode(v))
+                             : static_cast<uint32_t>(v);
+        args_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        break;
+      }
+      case ArgType::kInt64:
+      case ArgType::kUint64:
+      case ArgType::kPointer: {
+        if (!getVarint(p_, end_, v)) {
+          return fail("truncated record");
+        }
+        uint64_t value = type == ArgType::kInt64 ? static_cast<uint64_t>(zigzagDecode(v)) : v;
+        args_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        break;
+      }
+      case ArgType::kDouble:
+        if (end_ - p_ < 8) {
+          return fail("truncated record");
+        }
+        args_.append(p_, 8);
+        p_ += 8;
+        break;
+      case ArgType::kString: {
+        if (!getVarint(p_, end_, v) || v > static_cast<uint64_t>(end_ - p_) || v > UINT32_MAX) {
+          return fail("truncated record");
+        }
+        uint32_t length = static_cast<uint32_t>(v);
+        args_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        args_.append(p_, length);
+        p_ += length;
+        break;
+      }
+    }
+  }
+
+  if (!argsMatch(site.argTypes.data(), static_cast<uint32_t>(site.argTypes.size()), args_)) {
+    return fail("corrupt record");
+  }
+
+  record.timestamp = lastTimestamp_;
+  record.threadId = static_cast<uint32_t>(threadId);
+  record.siteId = static_cast<uint32_t>(siteId);
+  record.site = site.callSite.get();
+  record.args = args_;
+  return Status::kRecord;
+}
+
+}  // namespace halcyon::log::binary
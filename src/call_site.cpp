@@ -0,0 +1,45 @@
+#include "halcyon/log/call_site.h"
+
+#include <cstdlib>
+
+namespace halcyon::log {
+
+uint32_t CallSite::registerSelf() { return CallSiteRegistry::instance().add(*this); }
+
+CallSiteRegistry& CallSiteRegistry::instance() {
+  static CallSiteRegistry registry;
+  return registry;
+}
+
+CallSiteRegistry::~CallSiteRegistry() {
+  for (auto& chunk : chunks_) {
+    delete chunk.load(std::memory_order_relaxed);
+  }
+}
+
+uint32_t CallSiteRegistry::add(CallSite& site) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t id = site.id_.load(std::memory_order_relaxed);
+  if (id != 0) {
+    return id;
+  }
+  uint32_t index = size_.load(std::memory_order_relaxed);
+  if (index >= kChunkSize * kMaxChunks) {
+    std::abort();
+  }
+  std::atomic<Chunk*>& slot = chunks_[index / kChunkSize];
+  Chunk* chunk = slot.load(std::memory_order_relaxed);
+  if (chunk == nullptr) {
+    chunk = new Chunk;
+    slot.store(chunk, std::memory_order_release);
+  }
+  chunk->sites[index % kChunkSize].store(&site, std::memory_order_release);
+  id = index + 1;
+  size_.store(id, std::memory_order_release);
+  // Published last: a thread that sees the id also sees the table entry, and
+  // so does the backend once it reads a record carrying that id.
+  site.id_.store(id, std::memory_order_release);
+  return id;
+}
+
+}  // namespace halcyon::log
@@ -0,0 +1,95 @@
+#include "halcyon/log/clock.h"
+
+#if HALCYON_LOG_HAS_TSC
+#include <cpuid.h>
+#endif
+
+#include <chrono>
+#include <thread>
+
+namespace halcyon::log {
+
+namespace detail {
+
+ClockSource gClockSource = ClockSource::kSystem;
+
+}  // namespace detail
+
+namespace {
+
+int64_t readClock(clockid_t id) {
+  struct timespec ts;
+  ::clock_gettime(id, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+}  // namespace
+
+bool hasInvariantTsc() {
+#if HALCYON_LOG_HAS_TSC
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) {
+    return false;
+  }
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  return (edx & (1u << 8)) != 0;
+#else
+  return false;
+#endif
+}
+
+ClockSource TimestampConverter::select(ClockSource source) {
+  if (source != ClockSource::kSystem && hasInvariantTsc()) {
+    detail::gClockSource = ClockSource::kTsc;
+  } else {
+    detail::gClockSource = ClockSource::kSystem;
+  }
+  return detail::gClockSource;
+}
+
+TimestampConverter::Sample TimestampConverter::sample() {
+  Sample best{};
+#if HALCYON_LOG_HAS_TSC
+  // Bracket the clock reads with two TSC reads and keep the tightest of a
+  // few attempts so that a preemption does not skew the pairing.
+  uint64_t bestGap = UINT64_MAX;
+  for (int i = 0; i < 5; ++i) {
+    uint64_t before = __rdtsc();
+    int64_t monotonic = readClock(CLOCK_MONOTONIC_RAW);
+    int64_t realtime = readClock(CLOCK_REALTIME);
+    uint64_t after = __rdtsc();
+    if (after - before < bestGap) {
+      bestGap = after - before;
+      best = Sample{before + (after - before) / 2, monotonic, realtime};
+    }
+  }
+#else
+  best = Sample{0, readClock(CLOCK_MONOTONIC_RAW), readClock(CLOCK_REALTIME)};
+#endif
+  return best;
+}
+
+void TimestampConverter::calibrate(uint64_t windowNs) {
+  tsc_ = detail::gClockSource == ClockSource::kTsc;
+  if (!tsc_) {
+    return;
+  }
+  first_ = sample();
+  std::this_thread::sleep_for(std::chrono::nanoseconds(windowNs));
+  recalibrate();
+}
+
+void TimestampConverter::recalibrate() {
+  if (!tsc_) {
+    return;
+  }
+  Sample now = sample();
+  if (now.ticks > first_.ticks) {
+    nsPerTick_ = static_cast<double>(now.monotonicNs - first_.monotonicNs) /
+                 static_cast<double>(now.ticks - first_.ticks);
+  }
+  baseTicks_ = now.ticks;
+  baseNs_ = now.realtimeNs;
+}
+
+}  // namespace halcyon::log
@@ -0,0 +1,162 @@
+#include "halcyon/log/escape.h"
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace halcyon::log::detail {
+
+namespace {
+
+// Control characters, '"' and '\\' need escaping in JSON; a logfmt value
+// also has to be quoted for a space or '='.
+template <bool kLogfmt>
+bool isSpecial(char c) {
+  auto u = static_cast<unsigned char>(c);
+  return u < (kLogfmt ? 0x21 : 0x20) || c == '"' || c == '\\' || (kLogfmt && c == '=');
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HALCYON_LOG_HAS_AVX2_SCAN 1
+
+// The build targets baseline x86-64, so the AVX2 scan is compiled for that
+// one function and only called if the CPU has it.
+bool hasAvx2() {
+#if defined(__AVX2__)
+  return true;
+#else
+  static const bool has = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+  return has;
+#endif
+}
+
+// Scans `p` 32 bytes at a time from `i`. Returns the index of the first
+// special character, or `n` with `i` at the last block of fewer than 32.
+template <bool kLogfmt>
+__attribute__((target("avx2"))) size_t findSpecialAvx2(const char* p, size_t n, size_t& i) {
+  const __m256i limit = _mm256_set1_epi8(kLogfmt ? 0x20 : 0x1F);
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i equals = _mm256_set1_epi8('=');
+  for (; i + 32 <= n; i += 32) {
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(c, limit), c),
+                                  _mm256_or_si256(_mm256_cmpeq_epi8(c, quote),
+                                                  _mm256_cmpeq_epi8(c, backslash)));
+    if (kLogfmt) {
+      hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, equals));
+    }
+    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+    if (mask != 0) {
+      return i + static_cast<size_t>(std::countr_zero(mask));
+    }
+  }
+  return n;
+}
+#else
+#define HALCYON_LOG_HAS_AVX2_SCAN 0
+#endif
+
+// Index of the first special character of `s`, or its size.
+template <bool kLogfmt>
+size_t findSpecial(std::string_view s) {
+  const char* p = s.data();
+  size_t n = s.size();
+  size_t i = 0;
+  // A byte is a control character (or a space) iff min(c, limit) == c.
+#if HALCYON_LOG_HAS_AVX2_SCAN
+  if (n >= 32 && hasAvx2()) {
+    if (size_t hit = findSpecialAvx2<kLogfmt>(p, n, i); hit != n) {
+      return hit;
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    const __m128i limit = _mm_set1_epi8(kLogfmt ? 0x20 : 0x1F);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i equals = _mm_set1_epi8('=');
+    for (; i + 16 <= n; i += 16) {
+      __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      __m128i hit = _mm_or_si128(
+          _mm_cmpeq_epi8(_mm_min_epu8(c, limit), c),
+          _mm_or_si128(_mm_cmpeq_epi8(c, quote), _mm_cmpeq_epi8(c, backslash)));
+      if (kLogfmt) {
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, equals));
+      }
+      auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+      if (mask != 0) {
+        return i + static_cast<size_t>(std::countr_zero(mask));
+      }
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (isSpecial<kLogfmt>(p[i])) {
+      return i;
+    }
+  }
+  return n;
+}
+
+void appendEscape(std::string& out, char c) {
+  switch (c) {
+    case '"': out.append("\\\""); break;
+    case '\\': out.append("\\\\"); break;
+    case '\n': out.append("\\n"); break;
+    case '\r': out.append("\\r"); break;
+    case '\t': out.append("\\t"); break;
+    case '\b': out.append("\\b"); break;
+    case '\f': out.append("\\f"); break;
+    default: {
+      static constexpr char kHex[] = "0123456789abcdef";
+      auto u = static_cast<unsigned char>(c);
+      char buf[6] = {'\\', 'u', '0', '0', kHex[u >> 4], kHex[u & 15]};
+      out.append(buf, sizeof(buf));
+    }
+  }
+}
+
+}  // namespace
+
+void appendJsonEscaped(std::string& out, std::string_view s) {
+  for (;;) {
+    size_t i = findSpecial<false>(s);
+    out.append(s.data(), i);
+    if (i == s.size()) {
+      return;
+    }
+    appendEscape(out, s[i]);
+    s.remove_prefix(i + 1);
+  }
+}
+
+void appendLogfmtValue(std::string& out, std::string_view s) {
+  if (!s.empty() && findSpecial<true>(s) == s.size()) {
+    out.append(s);
+    return;
+  }
+  out.push_back('"');
+  appendJsonEscaped(out, s);
+  out.push_back('"');
+}
+
+void appendLogfmtKey(std::string& out, std::string_view s) {
+  if (s.empty()) {
+    out.push_back('_');
+    return;
+  }
+  size_t start = out.size();
+  out.append(s);
+  for (size_t i = start; i < out.size(); ++i) {
+    if (isSpecial<true>(out[i])) {
+      out[i] = '_';
+    }
+  }
+}
+
+}  // namespace halcyon::log::detail
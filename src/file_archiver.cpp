@@ -0,0 +1,243 @@
+#include "halcyon/log/file_archiver.h"
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if HALCYON_LOG_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace halcyon::log {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr size_t kCompressChunk = 256 * 1024;
+
+enum class RotatedKind { kNone, kPlain, kCompressed, kPartial };
+
+bool digits(std::string_view s, size_t n) {
+  return s.size() >= n && std::all_of(s.begin(), s.begin() + n, [](char c) {
+           return c >= '0' && c <= '9';
+         });
+}
+
+// Classifies `rest`, the part of a file name after `<base>.`, and extracts
+// its rotation order: the timestamp, then the collision counter.
+RotatedKind classify(std::string_view rest, std::string& stamp, unsigned& counter) {
+  if (!digits(rest, 8) || rest.size() < 15 || rest[8] != '-' || !digits(rest.substr(9), 6)) {
+    return RotatedKind::kNone;
+  }
+  stamp.assign(rest.substr(0, 15));
+  rest.remove_prefix(15);
+  counter = 0;
+  if (rest.size() >= 2 && rest[0] == '.' && digits(rest.substr(1), 1)) {
+    rest.remove_prefix(1);
+    while (!rest.empty() && rest[0] >= '0' && rest[0] <= '9') {
+      counter = counter * 10 + static_cast<unsigned>(rest[0] - '0');
+      rest.remove_prefix(1);
+    }
+  }
+  if (rest.empty()) {
+    return RotatedKind::kPlain;
+  }
+  if (rest == ".gz") {
+    return RotatedKind::kCompressed;
+  }
+  if (rest == ".gz.tmp") {
+    return RotatedKind::kPartial;
+  }
+  return RotatedKind::kNone;
+}
+
+// Lowest CPU priority and the idle I/O class for the calling thread only.
+void lowerPriority() {
+  constexpr int kIoprioWhoProcess = 1;
+  constexpr int kIoprioClassIdle = 3;
+  constexpr int kIoprioClassShift = 13;
+  auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+  ::setpriority(PRIO_PROCESS, tid, 19);
+  ::syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, kIoprioClassIdle << kIoprioClassShift);
+}
+
+}  // namespace
+
+FileArchiver::FileArchiver(const std::string& path, bool compress, size_t maxFiles,
+                           std::chrono::seconds maxAge)
+    : path_(path), compress_(compress), maxFiles_(maxFiles), maxAge_(maxAge) {
+#if !HALCYON_LOG_HAS_ZLIB
+  if (compress_) {
+    std::fprintf(stderr, "halcyon_log: built without zlib, rotated logs stay uncompressed\n");
+  }
+#endif
+  thread_ = std::thread([this] { run(); });
+}
+
+FileArchiver::~FileArchiver() {
+  stopping_.store(true, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+void FileArchiver::sweep() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sweepRequested_ = true;
+  }
+  wake_.notify_one();
+}
+
+std::string FileArchiver::rotatedName(const std::string& path,
+                                      std::chrono::system_clock::time_point now) {
+  time_t seconds = std::chrono::system_clock::to_time_t(now);
+  struct tm tm;
+  ::localtime_r(&seconds, &tm);
+  char stamp[32];
+  std::strftime(stamp, sizeof(stamp), ".%Y%m%d-%H%M%S", &tm);
+  std::string name = path + stamp;
+  std::string candidate = name;
+  std::error_code ec;
+  for (int n = 1; fs::exists(candidate, ec) || fs::exists(candidate + ".gz", ec); ++n) {
+    candidate = name + "." + std::to_string(n);
+  }
+  return candidate;
+}
+
+void FileArchiver::run() {
+  lowerPriority();
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_.wait(lock, [this] {
+      return sweepRequested_ || stopping_.load(std::memory_order_relaxed);
+    });
+    if (stopping_.load(std::memory_order_relaxed)) {
+      break;
+    }
+    sweepRequested_ = false;
+    lock.unlock();
+    sweepOnce();
+    lock.lock();
+  }
+}
+
+void FileArchiver::sweepOnce() {
+  fs::path active(path_);
+  fs::path dir = active.parent_path().empty() ? fs::path(".") : active.parent_path();
+  std::string prefix = active.filename().string() + ".";
+
+  struct Entry {
+    std::string name;
+    RotatedKind kind;
+    std::string stamp;
+    unsigned counter;
+  };
+  std::vector<Entry> entries;
+  std::error_code ec;
+  for (const auto& dirent : fs::directory_iterator(dir, ec)) {
+    std::string name = dirent.path().filename().string();
+    if (name.compare(0, prefix.size(), prefix) != 0) {
+      continue;
+    }
+    std::string stamp;
+    unsigned counter = 0;
+    RotatedKind kind = classify(std::string_view(name).substr(prefix.size()), stamp, counter);
+    if (kind == RotatedKind::kPartial) {
+      // Left by an interrupted compression; the source is still there.
+      fs::remove(dir / name, ec);
+    } else if (kind != RotatedKind::kNone) {
+      entries.push_back({std::move(name), kind, std::move(stamp), counter});
+    }
+  }
+
+  if (compress_) {
+    for (Entry& entry : entries) {
+      if (stopping_.load(std::memory_order_relaxed)) {
+        return;
+      }
+      if (entry.kind == RotatedKind::kPlain && compressFile((dir / entry.name).string())) {
+        entry.name += ".gz";
+        entry.kind = RotatedKind::kCompressed;
+      }
+    }
+  }
+
+  // Newest first.
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.stamp != b.stamp ? a.stamp > b.stamp : a.counter > b.counter;
+  });
+  auto oldest = fs::file_time_type::clock::now() - maxAge_;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    fs::path file = dir / entries[i].name;
+    bool tooMany = maxFiles_ != 0 && i >= maxFiles_;
+    bool tooOld = maxAge_.count() != 0 && fs::last_write_time(file, ec) < oldest && !ec;
+    if (tooMany || tooOld) {
+      fs::remove(file, ec);
+    }
+  }
+}
+
+bool FileArchiver::compressFile(const std::string& source) {
+#if HALCYON_LOG_HAS_ZLIB
+  std::string temp = source + ".gz.tmp";
+  int in = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in < 0) {
+    return false;
+  }
+  gzFile out = ::gzopen(temp.c_str(), "wb6e");
+  if (out == nullptr) {
+    ::close(in);
+    return false;
+  }
+  ::gzbuffer(out, kCompressChunk);
+  auto buffer = std::make_unique<char[]>(kCompressChunk);
+  bool ok = true;
+  for (;;) {
+    if (stopping_.load(std::memory_order_relaxed)) {
+      ok = false;
+      break;
+    }
+    ssize_t n = ::read(in, buffer.get(), kCompressChunk);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      ok = n == 0;
+      break;
+    }
+    if (::gzwrite(out, buffer.get(), static_cast<unsigned>(n)) != n) {
+      ok = false;
+      break;
+    }
+  }
+  ::close(in);
+  ok = ::gzclose(out) == Z_OK && ok;
+  if (!ok || ::rename(temp.c_str(), (source + ".gz").c_str()) != 0) {
+    ::unlink(temp.c_str());
+    return false;
+  }
+  ::unlink(source.c_str());
+  return true;
+#else
+  (void)source;
+  return false;
+#endif
+}
+
+}  // namespace halcyon::log
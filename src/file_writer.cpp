@@ -0,0 +1,254 @@
+#include "halcyon/log/file_writer.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <system_error>
+
+namespace halcyon::log {
+
+FileWriter::FileWriter(const std::string& path, int flags, const FileSinkOptions& options)
+    : options_(options),
+      path_(path),
+      flags_(flags | O_WRONLY | O_CREAT | O_CLOEXEC),
+      fd_(::open(path.c_str(), flags_, 0644)) {
+  struct stat st;
+  if (fd_ < 0 || ::fstat(fd_, &st) != 0) {
+    int error = errno;
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    throw std::system_error(error, std::generic_category(), "open " + path);
+  }
+  fileSize_ = static_cast<uint64_t>(st.st_size);
+  if (options_.rotateInterval.count() != 0) {
+    nextRotation_ = nextRotation(std::chrono::system_clock::now());
+  }
+  if (options_.maxFiles != 0 || options_.maxAge.count() != 0 || options_.compress) {
+    archiver_ = std::make_unique<FileArchiver>(path_, options_.compress, options_.maxFiles,
+                                               options_.maxAge);
+  }
+  current_.data = std::make_unique<char[]>(options_.bufferSize);
+  allocated_ = 1;
+  thread_ = std::thread([this] { run(); });
+}
+
+FileWriter::~FileWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_.size != 0) {
+      full_.push_back(std::move(current_));
+    }
+    stopping_ = true;
+  }
+  wakeFlusher_.notify_one();
+  thread_.join();
+  ::close(fd_);
+}
+
+void FileWriter::append(const char* data, size_t size) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // Keep lines whole within a buffer, and so within a file across rotation;
+  // only a line longer than a whole buffer is split.
+  if (size > options_.bufferSize - current_.size && current_.size != 0) {
+    handOff(lock);
+  }
+  while (size != 0) {
+    size_t n = std::min(size, options_.bufferSize - current_.size);
+    std::memcpy(current_.data.get() + current_.size, data, n);
+    current_.size += n;
+    data += n;
+    size -= n;
+    if (current_.size == options_.bufferSize) {
+      handOff(lock);
+    }
+  }
+}
+
+void FileWriter::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (current_.size != 0) {
+    handOff(lock);
+  }
+  batchWritten_.wait(lock, [this] { return written_ >= handedOff_; });
+}
+
+void FileWriter::flushAsync() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (current_.size != 0) {
+    handOff(lock);
+  }
+}
+
+// Queues the front buffer for the flusher and replaces it with a spare one.
+// Called on the backend thread, which waits for the flusher to free a buffer
+// if maxBuffers are already in flight.
+void FileWriter::handOff(std::unique_lock<std::mutex>& lock) {
+  full_.push_back(std::move(current_));
+  current_ = Buffer();
+  ++handedOff_;
+  wakeFlusher_.notify_one();
+  if (spare_.empty() && allocated_ >= options_.maxBuffers) {
+    batchWritten_.wait(lock, [this] { return !spare_.empty(); });
+  }
+  takeSpare();
+}
+
+void FileWriter::takeSpare() {
+  if (!spare_.empty()) {
+    current_ = std::move(spare_.back());
+    spare_.pop_back();
+    current_.size = 0;
+  } else {
+    current_.data = std::make_unique<char[]>(options_.bufferSize);
+    ++allocated_;
+  }
+}
+
+void FileWriter::run() {
+  std::vector<Buffer> batch;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    if (full_.empty() && !stopping_) {
+      bool woken = wakeFlusher_.wait_for(lock, options_.flushInterval,
+                                         [this] { return !full_.empty() || stopping_; });
+      // Time-based trigger: take the partially filled front buffer. No
+      // buffer can be in flight here, so a replacement never has to wait.
+      if (!woken && current_.size != 0) {
+        full_.push_back(std::move(current_));
+        current_ = Buffer();
+        ++handedOff_;
+        takeSpare();
+      }
+    }
+    if (full_.empty()) {
+      if (stopping_) {
+        break;
+      }
+      lock.unlock();
+      maybeRotate();
+      lock.lock();
+      continue;
+    }
+    batch.swap(full_);
+    lock.unlock();
+    writeBatch(batch);
+    maybeRotate();
+    lock.lock();
+    written_ += batch.size();
+    for (Buffer& buffer : batch) {
+      spare_.push_back(std::move(buffer));
+    }
+    batch.clear();
+    batchWritten_.notify_all();
+  }
+}
+
+void FileWriter::writeBatch(const std::vector<Buffer>& batch) {
+  std::vector<iovec> iov;
+  iov.reserve(batch.size());
+  for (const Buffer& buffer : batch) {
+    iov.push_back({buffer.data.get(), buffer.size});
+  }
+  size_t first = 0;
+  while (first < iov.size()) {
+    int count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+    ssize_t n = ::writev(fd_, &iov[first], count);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Nothing sensible to do with the records; report each new error once
+      // and drop the batch.
+      if (errno != lastError_) {
+        lastError_ = errno;
+        std::fprintf(stderr, "halcyon_log: write failed: %s\n", std::strerror(errno));
+      }
+      return;
+    }
+    lastError_ = 0;
+    fileSize_ += static_cast<uint64_t>(n);
+    // Skip what was written; a short write resumes mid-buffer.
+    size_t left = static_cast<size_t>(n);
+    while (first < iov.size() && left >= iov[first].iov_len) {
+      left -= iov[first].iov_len;
+      ++first;
+    }
+    if (first < iov.size()) {
+      iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+      iov[first].iov_len -= left;
+    }
+  }
+}
+
+void FileWriter::maybeRotate() {
+  bool bySize = options_.maxFileSize != 0 && fileSize_ >= options_.maxFileSize;
+  bool byTime = false;
+  if (options_.rotateInterval.count() != 0) {
+    auto now = std::chrono::system_clock::now();
+    if (now >= nextRotation_) {
+      byTime = true;
+      nextRotation_ = nextRotation(now);
+    }
+  }
+  if ((!bySize && !byTime) || fileSize_ == 0) {
+    return;
+  }
+
+  // Open the new file before giving up the old one, under a temporary name,
+  // so that a failure at any step leaves the current file in place and
+  // still being written.
+  std::string rotated = FileArchiver::rotatedName(path_, std::chrono::system_clock::now());
+  std::string next = path_ + ".new";
+  int fd = ::open(next.c_str(), flags_ | O_TRUNC, 0644);
+  bool ok = fd >= 0;
+  if (ok && ::rename(path_.c_str(), rotated.c_str()) != 0) {
+    ok = false;
+  } else if (ok && ::rename(next.c_str(), path_.c_str()) != 0) {
+    int error = errno;
+    ::rename(rotated.c_str(), path_.c_str());
+    errno = error;
+    ok = false;
+  }
+  if (!ok) {
+    if (errno != lastError_) {
+      lastError_ = errno;
+      std::fprintf(stderr, "halcyon_log: cannot rotate %s: %s\n", path_.c_str(),
+                   std::strerror(errno));
+    }
+    if (fd >= 0) {
+      ::close(fd);
+      ::unlink(next.c_str());
+    }
+    // Try again after another maxFileSize bytes rather than on every write.
+    fileSize_ = 0;
+    return;
+  }
+  ::close(fd_);
+  fd_ = fd;
+  fileSize_ = 0;
+  if (archiver_) {
+    archiver_->sweep();
+  }
+}
+
+// The first multiple of rotateInterval after `now`, counted in local time.
+std::chrono::system_clock::time_point FileWriter::nextRotation(
+    std::chrono::system_clock::time_point now) const {
+  time_t seconds = std::chrono::system_clock::to_time_t(now);
+  struct tm tm;
+  ::localtime_r(&seconds, &tm);
+  int64_t interval = options_.rotateInterval.count();
+  int64_t local = static_cast<int64_t>(seconds) + tm.tm_gmtoff;
+  int64_t next = (local / interval + 1) * interval - tm.tm_gmtoff;
+  return std::chrono::system_clock::from_time_t(static_cast<time_t>(next));
+}
+
+}  // namespace halcyon::log
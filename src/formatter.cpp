@@ -0,0 +1,363 @@
+#include "halcyon/log/formatter.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <type_traits>
+
+#include "halcyon/log/escape.h"
+#include "halcyon/log/number_format.h"
+
+namespace halcyon::log {
+
+namespace {
+
+using detail::putPair;
+
+const char* baseName(const char* path) {
+  const char* slash = std::strrchr(path, '/');
+  return slash ? slash + 1 : path;
+}
+
+void appendNumber(std::string& out, uint32_t v) {
+  char buf[detail::kMaxIntegerChars];
+  out.append(buf, detail::formatUnsigned(buf, v));
+}
+
+void appendPadded(std::string& out, std::string_view text, const FormatSpec& spec, bool numeric) {
+  size_t width = spec.width;
+  if (text.size() >= width) {
+    out.append(text);
+    return;
+  }
+  size_t pad = width - text.size();
+  if (numeric && spec.zeroPad && spec.align == FormatSpec::kAlignDefault) {
+    // Zeros go between the sign and the digits.
+    if (!text.empty() && (text[0] == '-' || text[0] == '+')) {
+      out.push_back(text[0]);
+      text.remove_prefix(1);
+    }
+    out.append(pad, '0');
+    out.append(text);
+    return;
+  }
+  bool left = spec.align == FormatSpec::kAlignLeft ||
+              (spec.align == FormatSpec::kAlignDefault && !numeric);
+  if (!left) {
+    out.append(pad, ' ');
+  }
+  out.append(text);
+  if (left) {
+    out.append(pad, ' ');
+  }
+}
+
+template <typename T>
+std::string_view integerText(char* buf, size_t size, T v, const FormatSpec& spec) {
+  int base = 10;
+  switch (spec.type) {
+    case 'x': case 'X': base = 16; break;
+    case 'o': base = 8; break;
+    case 'b': base = 2; break;
+    case 'c':
+      buf[0] = static_cast<char>(v);
+      return std::string_view(buf, 1);
+  }
+  char* begin = buf;
+  if (spec.plus && v >= 0) {
+    *begin++ = '+';
+  }
+  char* end;
+  if (base == 10) {
+    end = std::is_signed_v<T> ? detail::formatSigned(begin, static_cast<int64_t>(v))
+                              : detail::formatUnsigned(begin, static_cast<uint64_t>(v));
+  } else if (base == 16 && v >= 0) {
+    end = detail::formatHex(begin, static_cast<uint64_t>(v), spec.type == 'X');
+  } else {
+    end = std::to_chars(begin, buf + size, v, base).ptr;
+    if (spec.type == 'X') {
+      for (char* p = begin; p != end; ++p) {
+        if (*p >= 'a' && *p <= 'f') {
+          *p = static_cast<char>(*p - 'a' + 'A');
+        }
+      }
+    }
+  }
+  return std::string_view(buf, static_cast<size_t>(end - buf));
+}
+
+std::string_view doubleText(char* buf, size_t size, double v, const FormatSpec& spec) {
+  char* begin = buf;
+  if (spec.plus && !(v < 0)) {
+    *begin++ = '+';
+  }
+  std::chars_format fmt = spec.type == 'e'   ? std::chars_format::scientific
+                          : spec.type == 'g' ? std::chars_format::general
+                          : std::chars_format::fixed;
+  char* end;
+  if (spec.precision >= 0) {
+    end = fmt == std::chars_format::fixed
+              ? detail::formatFixed(begin, buf + size, v, spec.precision)
+              : std::to_chars(begin, buf + size, v, fmt, spec.precision).ptr;
+  } else if (spec.type != 0) {
+    end = std::to_chars(begin, buf + size, v, fmt).ptr;
+  } else {
+    end = detail::formatShortest(begin, buf + size, v);
+  }
+  return std::string_view(buf, static_cast<size_t>(end - buf));
+}
+
+// Renders one argument according to its spec.
+void appendArg(ArgReader& reader, ArgType type, const FormatSpec& spec, std::string& out) {
+  // Large enough for any double in fixed notation at kMaxPrecision.
+  char buf[512];
+  std::string_view text;
+  bool numeric = true;
+  switch (type) {
+    case ArgType::kBool:
+      text = reader.read<char>() ? "true" : "false";
+      numeric = false;
+      break;
+    case ArgType::kChar: {
+      char c = reader.read<char>();
+      if (spec.type == 0 || spec.type == 'c') {
+        buf[0] = c;
+        text = std::string_view(buf, 1);
+        numeric = false;
+      } else {
+        text = integerText(buf, sizeof(buf), static_cast<int32_t>(c), spec);
+      }
+      break;
+    }
+    case ArgType::kInt32:
+      text = integerText(buf, sizeof(buf), reader.read<int32_t>(), spec);
+      break;
+    case ArgType::kUint32:
+      text = integerText(buf, sizeof(buf), reader.read<uint32_t>(), spec);
+      break;
+    case ArgType::kInt64:
+      text = integerText(buf, sizeof(buf), reader.read<int64_t>(), spec);
+      break;
+    case ArgType::kUint64:
+      text = integerText(buf, sizeof(buf), reader.read<uint64_t>(), spec);
+      break;
+    case ArgType::kDouble:
+      text = doubleText(buf, sizeof(buf), reader.read<double>(), spec);
+      break;
+    case ArgType::kPointer: {
+      buf[0] = '0';
+      buf[1] = 'x';
+      char* end = detail::formatHex(buf + 2, reader.read<uint64_t>());
+      text = std::string_view(buf, static_cast<size_t>(end - buf));
+      break;
+    }
+    case ArgType::kString:
+      text = reader.readString();
+      if (spec.precision >= 0 && text.size() > static_cast<size_t>(spec.precision)) {
+        text = text.substr(0, static_cast<size_t>(spec.precision));
+      }
+      numeric = false;
+      break;
+  }
+  if (spec.width == 0) {
+    out.append(text);
+  } else {
+    appendPadded(out, text, spec, numeric);
+  }
+}
+
+}  // namespace
+
+void Formatter::appendTimestamp(int64_t timestamp, std::string& out) {
+  int64_t seconds = timestamp / 1000000000;
+  int64_t nanos = timestamp % 1000000000;
+  if (nanos < 0) {
+    --seconds;
+    nanos += 1000000000;
+  }
+  if (seconds != cachedSecond_) {
+    // Only a change of second goes through localtime_r; the date and time
+    // are then rendered once and reused for every record in that second.
+    time_t t = static_cast<time_t>(seconds);
+    struct tm tm;
+    ::localtime_r(&t, &tm);
+    unsigned year = static_cast<unsigned>(tm.tm_year + 1900) % 10000;
+    char* p = cachedPrefix_;
+    putPair(p, year / 100);
+    putPair(p + 2, year % 100);
+    p[4] = '-';
+    putPair(p + 5, static_cast<unsigned>(tm.tm_mon + 1));
+    p[7] = '-';
+    putPair(p + 8, static_cast<unsigned>(tm.tm_mday));
+    p[10] = layout_ == Layout::kText ? ' ' : 'T';
+    putPair(p + 11, static_cast<unsigned>(tm.tm_hour));
+    p[13] = ':';
+    putPair(p + 14, static_cast<unsigned>(tm.tm_min));
+    p[16] = ':';
+    putPair(p + 17, static_cast<unsigned>(tm.tm_sec));
+    p[19] = '.';
+    long offset = tm.tm_gmtoff / 60;
+    cachedOffset_[0] = offset < 0 ? '-' : '+';
+    offset = offset < 0 ? -offset : offset;
+    putPair(cachedOffset_ + 1, static_cast<unsigned>(offset / 60 % 100));
+    cachedOffset_[3] = ':';
+    putPair(cachedOffset_ + 4, static_cast<unsigned>(offset % 60));
+    cachedSecond_ = seconds;
+  }
+  // Patch the microseconds into a copy of the cached prefix.
+  char buf[kPrefixSize + 6];
+  std::memcpy(buf, cachedPrefix_, kPrefixSize);
+  unsigned micros = static_cast<unsigned>(nanos / 1000);
+  putPair(buf + kPrefixSize, micros / 10000);
+  putPair(buf + kPrefixSize + 2, micros / 100 % 100);
+  putPair(buf + kPrefixSize + 4, micros % 100);
+  out.append(buf, sizeof(buf));
+  if (layout_ != Layout::kText) {
+    out.append(cachedOffset_, kOffsetSize);
+  }
+}
+
+void Formatter::format(const Record& record, std::string& out) {
+  if (layout_ != Layout::kText) {
+    formatStructured(record, out);
+    return;
+  }
+  const CallSite& site = *record.site;
+  appendTimestamp(record.timestamp, out);
+  out.push_back(' ');
+  out.append(levelName(site.level));
+  out.push_back(' ');
+  appendNumber(out, record.threadId);
+  out.push_back(' ');
+  formatMessage(record, out);
+  if (site.structured) {
+    appendFields(record, out);
+  }
+  out.append(" - ");
+  out.append(baseName(site.file));
+  out.push_back(':');
+  appendNumber(out, site.line);
+  out.push_back('\n');
+}
+
+void Formatter::formatStructured(const Record& record, std::string& out) {
+  const CallSite& site = *record.site;
+  std::string_view level = levelName(site.level);
+  level = level.substr(0, level.find(' '));
+  scratch_.clear();
+  formatMessage(record, scratch_);
+  if (layout_ == Layout::kJson) {
+    out.append("{\"ts\":\"");
+    appendTimestamp(record.timestamp, out);
+    out.append("\",\"level\":\"");
+    out.append(level);
+    out.append("\",\"thread\":");
+    appendNumber(out, record.threadId);
+    out.append(",\"msg\":");
+  } else {
+    out.append("ts=");
+    appendTimestamp(record.timestamp, out);
+    out.append(" level=");
+    out.append(level);
+    out.append(" thread=");
+    appendNumber(out, record.threadId);
+    out.append(" msg=");
+  }
+  appendString(scratch_, out);
+  if (site.structured) {
+    appendFields(record, out);
+  }
+  if (layout_ == Layout::kJson) {
+    out.append(",\"file\":");
+    appendString(baseName(site.file), out);
+    out.append(",\"line\":");
+    appendNumber(out, site.line);
+    out.append("}\n");
+  } else {
+    out.append(" caller=");
+    out.append(baseName(site.file));
+    out.push_back(':');
+    appendNumber(out, site.line);
+    out.push_back('\n');
+  }
+}
+
+// The arguments of a structured record are key, value, key, value...; the
+// message itself has no placeholders and consumes none of them.
+void Formatter::appendFields(const Record& record, std::string& out) {
+  const CallSite& site = *record.site;
+  ArgReader reader(record.args);
+  for (uint32_t i = 0; i + 1 < site.argCount; i += 2) {
+    appendKey(reader.readString(), out);
+    appendValue(reader, site.argTypes[i + 1], out);
+  }
+}
+
+void Formatter::appendKey(std::string_view key, std::string& out) {
+  if (layout_ == Layout::kJson) {
+    out.push_back(',');
+    appendString(key, out);
+    out.push_back(':');
+  } else {
+    out.push_back(' ');
+    detail::appendLogfmtKey(out, key);
+    out.push_back('=');
+  }
+}
+
+// Numbers and booleans are written bare; everything else, and doubles that
+// JSON has no literal for, as strings.
+void Formatter::appendValue(ArgReader& reader, ArgType type, std::string& out) {
+  switch (type) {
+    case ArgType::kString:
+      appendString(reader.readString(), out);
+      return;
+    case ArgType::kDouble: {
+      double v = reader.read<double>();
+      char buf[32];
+      char* end = detail::formatShortest(buf, buf + sizeof(buf), v);
+      std::string_view text(buf, static_cast<size_t>(end - buf));
+      if (std::isfinite(v)) {
+        out.append(text);
+      } else {
+        appendString(text, out);
+      }
+      return;
+    }
+    case ArgType::kChar:
+    case ArgType::kPointer:
+      scratch_.clear();
+      appendArg(reader, type, FormatSpec{}, scratch_);
+      appendString(scratch_, out);
+      return;
+    default:
+      appendArg(reader, type, FormatSpec{}, out);
+      return;
+  }
+}
+
+void Formatter::appendString(std::string_view s, std::string& out) {
+  if (layout_ == Layout::kJson) {
+    out.push_back('"');
+    detail::appendJsonEscaped(out, s);
+    out.push_back('"');
+  } else {
+    detail::appendLogfmtValue(out, s);
+  }
+}
+
+void Formatter::formatMessage(const Record& record, std::string& out) {
+  const CallSite& site = *record.site;
+  ArgReader reader(record.args);
+  uint32_t nextArg = 0;
+  for (uint32_t i = 0; i < site.segmentCount; ++i) {
+    const FormatSegment& seg = site.segments[i];
+    out.append(site.format + seg.literalOffset, seg.literalLength);
+    if (seg.hasArg) {
+      appendArg(reader, site.argTypes[nextArg++], seg.spec, out);
+    }
+  }
+}
+
+}  // namespace halcyon::log
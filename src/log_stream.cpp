@@ -0,0 +1,89 @@
+#include "halcyon/log/log_stream.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "halcyon/log/number_format.h"
+
+namespace halcyon::log {
+
+namespace {
+
+// Enough for any integer, pointer or shortest round-trip double.
+constexpr size_t kMaxNumberSize = 32;
+
+// The spill buffer of the thread's last long message.
+struct SpareBuffer {
+  std::unique_ptr<char[]> data;
+  size_t capacity = 0;
+};
+
+thread_local SpareBuffer tSpare;
+
+}  // namespace
+
+void LogStream::grow(size_t n) {
+  size_t capacity = std::max(capacity_ * 2, size_ + n);
+  std::unique_ptr<char[]> heap;
+  if (tSpare.capacity >= capacity) {
+    heap = std::move(tSpare.data);
+    capacity = std::exchange(tSpare.capacity, 0);
+  } else {
+    heap = std::make_unique_for_overwrite<char[]>(capacity);
+  }
+  std::memcpy(heap.get(), data_, size_);
+  heap_ = std::move(heap);
+  data_ = heap_.get();
+  capacity_ = capacity;
+}
+
+// Keeps the larger of this message's buffer and the thread's spare.
+void LogStream::recycle() {
+  if (capacity_ > tSpare.capacity && capacity_ <= kMaxSpareSize) {
+    tSpare.data = std::move(heap_);
+    tSpare.capacity = capacity_;
+  }
+}
+
+template <typename T>
+LogStream& LogStream::appendInteger(T v) {
+  char* p = reserve(kMaxNumberSize);
+  char* end = std::is_signed_v<T> ? detail::formatSigned(p, static_cast<int64_t>(v))
+                                  : detail::formatUnsigned(p, static_cast<uint64_t>(v));
+  size_ += static_cast<size_t>(end - p);
+  return *this;
+}
+
+template <typename T>
+LogStream& LogStream::appendFloat(T v) {
+  char* p = reserve(kMaxNumberSize);
+  // Shortest round trip for the type itself: a float is not widened, which
+  // would print its binary expansion as a double.
+  size_ += static_cast<size_t>(std::to_chars(p, p + kMaxNumberSize, v).ptr - p);
+  return *this;
+}
+
+LogStream& LogStream::operator<<(const void* p) {
+  char* out = reserve(kMaxNumberSize);
+  out[0] = '0';
+  out[1] = 'x';
+  char* end = detail::formatHex(out + 2, reinterpret_cast<uintptr_t>(p));
+  size_ += static_cast<size_t>(end - out);
+  return *this;
+}
+
+template LogStream& LogStream::appendInteger(short);
+template LogStream& LogStream::appendInteger(unsigned short);
+template LogStream& LogStream::appendInteger(int);
+template LogStream& LogStream::appendInteger(unsigned int);
+template LogStream& LogStream::appendInteger(long);
+template LogStream& LogStream::appendInteger(unsigned long);
+template LogStream& LogStream::appendInteger(long long);
+template LogStream& LogStream::appendInteger(unsigned long long);
+template LogStream& LogStream::appendFloat(float);
+template LogStream& LogStream::appendFloat(double);
+
+}  // namespace halcyon::log
@@ -0,0 +1,116 @@
+#include "halcyon/log/logger.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "halcyon/log/backend.h"
+
+namespace halcyon::log {
+
+namespace detail {
+
+constinit Logger gRootLogger(Level::kInfo);
+
+void fatal() {
+  Backend::instance().flush();
+  std::abort();
+}
+
+}  // namespace detail
+
+Logger::Logger(Logger* parent, std::string_view name, std::string_view leaf)
+    : level_(parent->level()),
+      ownLevel_(kInherit),
+      overflow_(parent->overflowPolicy()),
+      parent_(parent),
+      name_(name),
+      leaf_(leaf) {}
+
+void Logger::setLevel(Level level) {
+  ownLevel_.store(static_cast<uint8_t>(level));
+  refresh();
+}
+
+void Logger::clearLevel() {
+  if (parent_ != nullptr) {
+    ownLevel_.store(kInherit);
+    refresh();
+  }
+}
+
+// Recomputes the effective level from the logger's own and its parent's,
+// then does the same down the subtree. Everyone who changes an input
+// refreshes afterwards, and a refresh that raced with such a change sees it
+// on the re-check and goes again, so the last value stored is never stale.
+// The operations are sequentially consistent; none of this is on the
+// logging path.
+void Logger::refresh() {
+  for (;;) {
+    uint8_t own = ownLevel_.load();
+    Level inherited = parent_ != nullptr ? parent_->level_.load() : Level::kInfo;
+    level_.store(own != kInherit ? static_cast<Level>(own) : inherited);
+    if (ownLevel_.load() == own && (parent_ == nullptr || parent_->level_.load() == inherited)) {
+      break;
+    }
+  }
+  for (Logger* c = firstChild_.load(std::memory_order_acquire); c != nullptr; c = c->nextSibling_) {
+    c->refresh();
+  }
+}
+
+Logger& Logger::child(std::string_view leaf) {
+  Logger* head = firstChild_.load(std::memory_order_acquire);
+  for (Logger* c = head; c != nullptr; c = c->nextSibling_) {
+    if (c->leaf_ == leaf) {
+      return *c;
+    }
+  }
+  // The name is spelled out once, for the lifetime of the logger.
+  size_t size = name_.empty() ? leaf.size() : name_.size() + 1 + leaf.size();
+  char* text = new char[size];
+  if (!name_.empty()) {
+    std::memcpy(text, name_.data(), name_.size());
+    text[name_.size()] = '.';
+  }
+  std::memcpy(text + size - leaf.size(), leaf.data(), leaf.size());
+  auto* created = new Logger(this, std::string_view(text, size),
+                             std::string_view(text + size - leaf.size(), leaf.size()));
+  created->nextSibling_ = head;
+  while (!firstChild_.compare_exchange_weak(created->nextSibling_, created,
+                                            std::memory_order_acq_rel)) {
+    // Another thread added a child; it may be this one.
+    for (Logger* c = created->nextSibling_; c != head; c = c->nextSibling_) {
+      if (c->leaf_ == leaf) {
+        delete created;
+        delete[] text;
+        return *c;
+      }
+    }
+    head = created->nextSibling_;
+  }
+  created->refresh();
+  return *created;
+}
+
+Logger& Logger::get(std::string_view name) {
+  Logger* logger = &root();
+  while (!name.empty()) {
+    size_t dot = name.find('.');
+    std::string_view leaf = name.substr(0, dot);
+    if (!leaf.empty()) {
+      logger = &logger->child(leaf);
+    }
+    name = dot == std::string_view::npos ? std::string_view() : name.substr(dot + 1);
+  }
+  return *logger;
+}
+
+uint32_t currentThreadId() {
+  thread_local uint32_t tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+  return tid;
+}
+
+}  // namespace halcyon::log
@@ -0,0 +1,185 @@
+#include "halcyon/log/mmap_sink.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+
+namespace halcyon::log {
+
+namespace {
+
+// Delay before retrying after a segment could not be created.
+constexpr std::chrono::seconds kRetryInterval{1};
+
+}  // namespace
+
+MmapFileSink::MmapFileSink(const std::string& path, const MmapFileSinkOptions& options)
+    : path_(path), options_(options) {
+  if (int error = createSegment(current_); error != 0) {
+    throw std::system_error(error, std::generic_category(), "create segment of " + path);
+  }
+  thread_ = std::thread([this] { run(); });
+}
+
+MmapFileSink::~MmapFileSink() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_.data != nullptr) {
+      retired_.push_back(std::move(current_));
+    }
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+  // The spare was never written to; closing it removes the file.
+  if (spare_.data != nullptr) {
+    closeSegment(spare_);
+  }
+}
+
+void MmapFileSink::write(std::string_view line) {
+  size_t segmentSize = options_.segmentSize;
+  // A line is never split across segments, so one longer than a whole
+  // segment is cut down to fit one, keeping its newline.
+  bool truncated = line.size() > segmentSize;
+  size_t size = truncated ? segmentSize : line.size();
+  if (current_.data == nullptr || segmentSize - current_.used < size) {
+    roll();
+    if (current_.data == nullptr) {
+      return;  // no segment could be created; the error has been reported
+    }
+  }
+  char* out = current_.data + current_.used;
+  if (truncated && line.back() == '\n') {
+    std::memcpy(out, line.data(), size - 1);
+    out[size - 1] = '\n';
+  } else {
+    std::memcpy(out, line.data(), size);
+  }
+  current_.used += size;
+}
+
+// Retires the current segment and switches to the spare. Only waits if lines
+// arrive faster than the background thread can preallocate segments.
+void MmapFileSink::roll() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (current_.data != nullptr) {
+    retired_.push_back(std::move(current_));
+    current_ = Segment();
+  }
+  spareReady_.wait(lock, [this] { return spare_.data != nullptr || spareFailed_; });
+  if (spare_.data != nullptr) {
+    current_ = std::move(spare_);
+    spare_ = Segment();
+  }
+  wake_.notify_one();
+}
+
+void MmapFileSink::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    if (!retired_.empty()) {
+      std::vector<Segment> retired;
+      retired.swap(retired_);
+      lock.unlock();
+      for (Segment& segment : retired) {
+        closeSegment(segment);
+      }
+      lock.lock();
+      continue;
+    }
+    if (stopping_) {
+      break;
+    }
+    if (spare_.data == nullptr && !spareFailed_) {
+      Segment segment;
+      lock.unlock();
+      int error = createSegment(segment);
+      lock.lock();
+      if (error != 0) {
+        if (error != lastError_) {
+          lastError_ = error;
+          std::fprintf(stderr, "halcyon_log: cannot create log segment: %s\n",
+                       std::strerror(error));
+        }
+        spareFailed_ = true;
+      } else {
+        lastError_ = 0;
+        spare_ = std::move(segment);
+      }
+      spareReady_.notify_all();
+      continue;
+    }
+    if (spareFailed_) {
+      wake_.wait_for(lock, kRetryInterval, [this] { return stopping_ || !retired_.empty(); });
+      spareFailed_ = false;
+    } else {
+      wake_.wait(lock, [this] {
+        return stopping_ || !retired_.empty() || spare_.data == nullptr;
+      });
+    }
+  }
+}
+
+int MmapFileSink::createSegment(Segment& segment) {
+  char suffix[16];
+  for (;;) {
+    std::snprintf(suffix, sizeof(suffix), ".%06u", nextIndex_++);
+    segment.path = path_ + suffix;
+    segment.fd = ::open(segment.path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (segment.fd >= 0) {
+      break;
+    }
+    if (errno != EEXIST) {
+      return errno;
+    }
+  }
+
+  size_t size = options_.segmentSize;
+  int error = 0;
+  if (::fallocate(segment.fd, 0, 0, static_cast<off_t>(size)) != 0) {
+    // Filesystems without fallocate get a sparse file instead.
+    if ((errno != EOPNOTSUPP && errno != ENOSYS) ||
+        ::ftruncate(segment.fd, static_cast<off_t>(size)) != 0) {
+      error = errno;
+    }
+  }
+  if (error == 0) {
+    // Prefault here, off the backend thread, so that memcpy into the
+    // segment does not take page faults.
+    void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        segment.fd, 0);
+    if (data != MAP_FAILED) {
+      segment.data = static_cast<char*>(data);
+      segment.used = 0;
+      return 0;
+    }
+    error = errno;
+  }
+  ::close(segment.fd);
+  ::unlink(segment.path.c_str());
+  segment = Segment();
+  return error;
+}
+
+void MmapFileSink::closeSegment(Segment& segment) {
+  ::msync(segment.data, segment.used, MS_ASYNC);
+  ::munmap(segment.data, options_.segmentSize);
+  if (segment.used == 0) {
+    ::unlink(segment.path.c_str());
+  } else if (::ftruncate(segment.fd, static_cast<off_t>(segment.used)) != 0) {
+    std::fprintf(stderr, "halcyon_log: cannot truncate %s: %s\n", segment.path.c_str(),
+                 std::strerror(errno));
+  }
+  ::close(segment.fd);
+  segment = Segment();
+}
+
+}  // namespace halcyon::log
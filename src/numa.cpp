@@ -0,0 +1,99 @@
+#include "halcyon/log/numa.h"
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace halcyon::log {
+
+namespace {
+
+// Expands a sysfs list such as "0-3,8-11".
+std::vector<int> parseList(std::string_view text) {
+  std::vector<int> values;
+  while (!text.empty()) {
+    size_t comma = text.find(',');
+    std::string_view range = text.substr(0, comma);
+    text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+    int first = 0;
+    auto [end, ec] = std::from_chars(range.data(), range.data() + range.size(), first);
+    if (ec != std::errc()) {
+      continue;
+    }
+    int last = first;
+    if (end != range.data() + range.size() && *end == '-') {
+      std::from_chars(end + 1, range.data() + range.size(), last);
+    }
+    for (int value = first; value <= last; ++value) {
+      values.push_back(value);
+    }
+  }
+  return values;
+}
+
+std::vector<int> readList(const std::string& path) {
+  std::ifstream in(path);
+  std::string line;
+  std::getline(in, line);
+  return parseList(line);
+}
+
+}  // namespace
+
+std::vector<NumaNode> numaNodes() {
+  std::vector<NumaNode> nodes;
+  for (int id : readList("/sys/devices/system/node/online")) {
+    std::vector<int> cpus =
+        readList("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+    if (!cpus.empty()) {
+      nodes.push_back(NumaNode{id, std::move(cpus)});
+    }
+  }
+  return nodes;
+}
+
+int currentNumaNode() {
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+    return -1;
+  }
+  return static_cast<int>(node);
+}
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+bool bindToNode(void* data, size_t size, int node) {
+  constexpr int kMpolPreferred = 1;
+  constexpr unsigned kMpolMfMove = 1u << 1;
+  constexpr size_t kBitsPerWord = 64;
+  auto pageSize = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+  auto begin = (reinterpret_cast<uintptr_t>(data) + pageSize - 1) & ~(pageSize - 1);
+  auto end = (reinterpret_cast<uintptr_t>(data) + size) & ~(pageSize - 1);
+  if (node < 0 || end <= begin) {
+    return false;
+  }
+  std::vector<uint64_t> mask(static_cast<size_t>(node) / kBitsPerWord + 1);
+  mask.back() = uint64_t{1} << (static_cast<size_t>(node) % kBitsPerWord);
+  // The kernel reads one bit less than it is told.
+  return ::syscall(SYS_mbind, begin, end - begin, kMpolPreferred, mask.data(),
+                   mask.size() * kBitsPerWord + 1, kMpolMfMove) == 0;
+}
+
+}  // namespace halcyon::log
@@ -0,0 +1,64 @@
+#include "halcyon/log/number_format.h"
+
+#include <cmath>
+
+namespace halcyon::log::detail {
+
+namespace {
+
+// Beyond this the scaled value may not fit the 53-bit mantissa anyway.
+constexpr int kMaxFastPrecision = 15;
+constexpr double kMaxExactInteger = 9007199254740992.0;  // 2^53
+constexpr double kEpsilon = 0x1p-52;
+
+}  // namespace
+
+char* formatFixed(char* out, char* end, double v, int precision) {
+  if (precision <= kMaxFastPrecision && std::isfinite(v) &&
+      end - out >= static_cast<ptrdiff_t>(kMaxIntegerChars + 2 + kMaxFastPrecision)) {
+    double scaled = std::fabs(v) * static_cast<double>(kPowersOf10[precision]);
+    if (scaled < kMaxExactInteger) {
+      double whole = std::floor(scaled);
+      double fraction = scaled - whole;
+      // The product is off from the exact one by at most half an ulp, which
+      // can only change the rounding if the fraction is that close to one
+      // half. Those, exact ties included, are left to to_chars.
+      if (std::fabs(fraction - 0.5) > scaled * kEpsilon) {
+        auto units = static_cast<uint64_t>(whole) + (fraction > 0.5 ? 1 : 0);
+        // Split off the integer part without dividing by a variable power
+        // of ten: rounding is monotonic, so the digits after the point are
+        // at least zero and at most one unit, which carries.
+        uint64_t unit = kPowersOf10[precision];
+        auto integer = static_cast<uint64_t>(std::fabs(v));
+        uint64_t digits = units - integer * unit;
+        if (digits == unit) {
+          ++integer;
+          digits = 0;
+        }
+        char* p = out;
+        if (std::signbit(v)) {
+          *p++ = '-';
+        }
+        p = formatUnsigned(p, integer);
+        if (precision > 0) {
+          *p++ = '.';
+          char* q = p + precision;
+          int left = precision;
+          for (; left >= 2; left -= 2) {
+            q -= 2;
+            putPair(q, static_cast<unsigned>(digits % 100));
+            digits /= 100;
+          }
+          if (left != 0) {
+            q[-1] = static_cast<char>('0' + digits);
+          }
+          p += precision;
+        }
+        return p;
+      }
+    }
+  }
+  return std::to_chars(out, end, v, std::chars_format::fixed, precision).ptr;
+}
+
+}  // namespace halcyon::log::detail
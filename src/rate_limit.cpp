@@ -0,0 +1,31 @@
+#include "halcyon/log/rate_limit.h"
+
+namespace halcyon::log {
+
+namespace {
+
+constinit std::atomic<SiteLimiter*> gFirstLimiter{nullptr};
+
+}  // namespace
+
+SiteLimiter* SiteLimiter::first() { return gFirstLimiter.load(std::memory_order_acquire); }
+
+void SiteLimiter::link(const CallSite& site) {
+  if (linked_.exchange(true, std::memory_order_relaxed)) {
+    return;
+  }
+  site_ = &site;
+  SiteLimiter* head = gFirstLimiter.load(std::memory_order_relaxed);
+  do {
+    next_ = head;
+  } while (!gFirstLimiter.compare_exchange_weak(head, this, std::memory_order_release,
+                                                std::memory_order_relaxed));
+}
+
+namespace detail {
+
+void rateNotPositive() {}
+
+}  // namespace detail
+
+}  // namespace halcyon::log
@@ -0,0 +1,59 @@
+#include "halcyon/log/sink.h"
+
+#include <fcntl.h>
+
+#include <chrono>
+
+namespace halcyon::log {
+
+namespace {
+
+// A binary file is only readable from its header on, which the encoder
+// writes once; rotating underneath it would orphan the records that follow.
+FileSinkOptions withoutRotation(FileSinkOptions options) {
+  options.maxFileSize = 0;
+  options.rotateInterval = std::chrono::seconds(0);
+  return options;
+}
+
+}  // namespace
+
+ConsoleSink::ConsoleSink(bool useStderr) : stream_(useStderr ? stderr : stdout) {}
+
+void ConsoleSink::write(std::string_view line) {
+  ::fwrite_unlocked(line.data(), 1, line.size(), stream_);
+}
+
+void ConsoleSink::flush() { ::fflush(stream_); }
+
+FileSink::FileSink(const std::string& path, const FileSinkOptions& options)
+    : writer_(path, O_APPEND, options) {}
+
+void FileSink::write(std::string_view line) { writer_.append(line.data(), line.size()); }
+
+void FileSink::flush() { writer_.flush(); }
+
+void FileSink::flushAsync() { writer_.flushAsync(); }
+
+BinaryFileSink::BinaryFileSink(const std::string& path, const FileSinkOptions& options)
+    : writer_(path, O_TRUNC, withoutRotation(options)) {
+  int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+  encoder_.writeHeader(frame_, now);
+  writer_.append(frame_.data(), frame_.size());
+  addBytesWritten(frame_.size());
+}
+
+void BinaryFileSink::writeRecord(const Record& record) {
+  frame_.clear();
+  encoder_.writeRecord(frame_, record);
+  writer_.append(frame_.data(), frame_.size());
+  addBytesWritten(frame_.size());
+}
+
+void BinaryFileSink::flush() { writer_.flush(); }
+
+void BinaryFileSink::flushAsync() { writer_.flushAsync(); }
+
+}  // namespace halcyon::log
@@ -0,0 +1,58 @@
+#include "halcyon/log/stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace halcyon::log {
+
+namespace detail {
+
+constinit std::atomic<double> gEnqueueNsPerTick{0.0};
+
+}  // namespace detail
+
+uint64_t HistogramSnapshot::percentile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  double exact = std::clamp(q, 0.0, 1.0) * static_cast<double>(count);
+  uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(exact)), 1);
+  uint64_t seen = 0;
+  for (int i = 0; i < HistogramBuckets::kCount; ++i) {
+    seen += buckets[static_cast<size_t>(i)];
+    if (seen >= rank) {
+      return std::min(HistogramBuckets::upperBound(i), max);
+    }
+  }
+  return max;
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot& other) {
+  count += other.count;
+  sum += other.sum;
+  max = std::max(max, other.max);
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    buckets[i] += other.buckets[i];
+  }
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+  HistogramSnapshot snapshot;
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.buckets[i];
+  }
+  snapshot.sum = sum_.load(std::memory_order_relaxed);
+  snapshot.max = max_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void LatencyHistogram::assign(const HistogramSnapshot& snapshot) {
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    buckets_[i].store(snapshot.buckets[i], std::memory_order_relaxed);
+  }
+  sum_.store(snapshot.sum, std::memory_order_relaxed);
+  max_.store(snapshot.max, std::memory_order_relaxed);
+}
+
+}  // namespace halcyon::log
@@ -0,0 +1,216 @@
+#include "halcyon/log/thread_context.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <thread>
+#include <utility>
+
+#include "halcyon/log/backend.h"
+#include "halcyon/log/call_site.h"
+#include "halcyon/log/numa.h"
+#include "halcyon/log/record.h"
+
+namespace halcyon::log {
+
+namespace {
+
+// Roughly tens of microseconds of pause instructions.
+constexpr int kSpinIterations = 2048;
+constexpr std::chrono::microseconds kBlockSleep{50};
+
+// Owned by the thread_local below; retires the context when the thread exits
+// so the backend can drain what is left and free it.
+struct LocalContextHolder {
+  std::shared_ptr<ThreadContext> context;
+
+  ~LocalContextHolder() {
+    if (context) {
+      context->retire();
+    }
+  }
+};
+
+}  // namespace
+
+ThreadContext& ThreadContext::local() {
+  thread_local LocalContextHolder holder;
+  if (HALCYON_LOG_UNLIKELY(!holder.context)) {
+    // Starting here keeps the check off the per-record path and guarantees
+    // the ring capacity from the options is in place before the first ring
+    // is created.
+    Backend::instance().ensureStarted();
+    holder.context = ThreadContextRegistry::instance().create(currentThreadId());
+  }
+  return *holder.context;
+}
+
+char* ThreadContext::makeRoom(size_t size, OverflowPolicy policy, Level level) {
+  char* p;
+  switch (policy) {
+    case OverflowPolicy::kDropNewest:
+      countDrop(level);
+      return nullptr;
+    case OverflowPolicy::kOverwriteOldest:
+      if (!ring_.overwriteEnabled()) {
+        countDrop(level);
+        return nullptr;
+      }
+      while ((p = ring_.prepareWrite(size)) == nullptr) {
+        if (const char* oldest = ring_.discardOldest()) {
+          RecordHeader header;
+          std::memcpy(&header, oldest, sizeof(header));
+          const CallSite* site = CallSiteRegistry::instance().find(header.siteId);
+          countDrop(site != nullptr ? site->level : level);
+        }
+      }
+      return p;
+    case OverflowPolicy::kSpinThenBlock:
+      for (int i = 0; i < kSpinIterations; ++i) {
+        cpuRelax();
+        if ((p = ring_.prepareWrite(size)) != nullptr) {
+          return p;
+        }
+      }
+      break;
+    case OverflowPolicy::kBlock:
+      break;
+  }
+  while ((p = ring_.prepareWrite(size)) == nullptr) {
+    std::this_thread::sleep_for(kBlockSleep);
+  }
+  return p;
+}
+
+void ThreadContext::addStats(LogStats& stats) const {
+  for (int level = 0; level < kNumLevels; ++level) {
+    stats.dropped[level] += dropped(static_cast<Level>(level));
+  }
+  stats.queueHighWater =
+      std::max(stats.queueHighWater, queueHighWater_.load(std::memory_order_relaxed));
+  stats.enqueueLatency.merge(enqueueLatency_.snapshot());
+}
+
+ThreadContextRegistry& ThreadContextRegistry::instance() {
+  static ThreadContextRegistry registry;
+  return registry;
+}
+
+void ThreadContextRegistry::setRingCapacity(size_t bytes) {
+  ringCapacity_.store(std::bit_ceil(std::max<size_t>(bytes, 4096)), std::memory_order_relaxed);
+}
+
+void ThreadContextRegistry::setNodes(std::vector<int> nodes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  nodes_ = std::move(nodes);
+}
+
+std::shared_ptr<ThreadContext> ThreadContextRegistry::create(uint32_t threadId) {
+  size_t capacity = ringCapacity_.load(std::memory_order_relaxed);
+  int node = ThreadContext::kAnyNode;
+  std::unique_ptr<char[]> buffer;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!nodes_.empty()) {
+      node = currentNumaNode();
+      if (std::find(nodes_.begin(), nodes_.end(), node) == nodes_.end()) {
+        node = nodes_.front();
+      }
+    }
+    if (spareRingCapacity_ == capacity) {
+      auto spare = std::find_if(spareRings_.rbegin(), spareRings_.rend(),
+                                [node](const SpareRing& ring) { return ring.node == node; });
+      if (spare != spareRings_.rend()) {
+        buffer = std::move(spare->buffer);
+        spareRings_.erase(std::next(spare).base());
+      }
+    }
+  }
+  if (!buffer) {
+    buffer = std::make_unique_for_overwrite<char[]>(capacity);
+    // The thread touches the pages first anyway, but the allocator may hand
+    // out memory already faulted in on another node.
+    if (node != ThreadContext::kAnyNode) {
+      bindToNode(buffer.get(), capacity, node);
+    }
+  }
+  auto context = std::make_shared<ThreadContext>(threadId, node, std::move(buffer), capacity);
+  std::lock_guard<std::mutex> lock(mutex_);
+  contexts_.push_back(context);
+  version_.fetch_add(1, std::memory_order_release);
+  return context;
+}
+
+void ThreadContextRegistry::snapshot(std::vector<std::shared_ptr<ThreadContext>>& contexts,
+                                     uint64_t& version, int node) {
+  if (version_.load(std::memory_order_acquire) == version) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  contexts.clear();
+  for (const auto& context : contexts_) {
+    if (node == ThreadContext::kAnyNode || context->node() == node) {
+      contexts.push_back(context);
+    }
+  }
+  version = version_.load(std::memory_order_relaxed);
+}
+
+bool ThreadContextRegistry::reclaim(int node) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto drained = [node](const std::shared_ptr<ThreadContext>& context) {
+    // Another node's rings may be in the middle of a drain on its thread.
+    // The retired flag is checked first: once it is set the owner will not
+    // write again, so an empty ring stays empty.
+    return (node == ThreadContext::kAnyNode || context->node() == node) && context->retired() &&
+           context->ring().empty();
+  };
+  auto it = std::stable_partition(contexts_.begin(), contexts_.end(),
+                                 [&](const auto& context) { return !drained(context); });
+  if (it == contexts_.end()) {
+    return false;
+  }
+  for (auto reclaimed = it; reclaimed != contexts_.end(); ++reclaimed) {
+    (*reclaimed)->addStats(reclaimed_);
+    // The backend refreshes its snapshot right after reclaiming, without
+    // touching the rings in between, so the buffer can be taken now.
+    SpscRing& ring = (*reclaimed)->ring();
+    if (ring.capacity() != spareRingCapacity_) {
+      spareRings_.clear();
+      spareRingCapacity_ = ring.capacity();
+    }
+    if (spareRings_.size() < kMaxSpareRings) {
+      spareRings_.push_back(SpareRing{ring.releaseBuffer(), (*reclaimed)->node()});
+    }
+  }
+  contexts_.erase(it, contexts_.end());
+  version_.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+std::array<uint64_t, kNumLevels> ThreadContextRegistry::droppedRecords() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::array<uint64_t, kNumLevels> counts = reclaimed_.dropped;
+  for (const auto& context : contexts_) {
+    for (int level = 0; level < kNumLevels; ++level) {
+      counts[level] += context->dropped(static_cast<Level>(level));
+    }
+  }
+  return counts;
+}
+
+void ThreadContextRegistry::collectStats(LogStats& stats) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int level = 0; level < kNumLevels; ++level) {
+    stats.dropped[level] += reclaimed_.dropped[level];
+  }
+  stats.queueHighWater = std::max(stats.queueHighWater, reclaimed_.queueHighWater);
+  stats.enqueueLatency.merge(reclaimed_.enqueueLatency);
+  for (const auto& context : contexts_) {
+    context->addStats(stats);
+  }
+}
+
+}  // namespace halcyon::log
@@ -0,0 +1,380 @@
+#include "halcyon/log/uring_sink.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+// IORING_FEAT_RW_CUR_POS arrived together with IORING_OP_WRITE (Linux 5.6).
+#if defined(IORING_FEAT_RW_CUR_POS) && defined(__NR_io_uring_setup)
+#define HALCYON_LOG_HAS_IO_URING 1
+#else
+#define HALCYON_LOG_HAS_IO_URING 0
+#endif
+
+namespace halcyon::log {
+
+namespace {
+
+// user_data of the fdatasync requests; writes carry their buffer index.
+constexpr uint64_t kSyncTag = UINT64_MAX;
+
+}  // namespace
+
+#if HALCYON_LOG_HAS_IO_URING
+
+// The submission and completion rings shared with the kernel, driven with
+// raw system calls so that liburing is not required.
+struct UringFileSink::Ring {
+  int fd = -1;
+  bool fixedBuffers = false;
+  void* sqMemory = MAP_FAILED;
+  size_t sqMemorySize = 0;
+  void* cqMemory = MAP_FAILED;
+  size_t cqMemorySize = 0;
+  io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+  size_t sqesSize = 0;
+
+  unsigned* sqHead = nullptr;
+  unsigned* sqTail = nullptr;
+  unsigned sqMask = 0;
+  unsigned* sqArray = nullptr;
+  unsigned* cqHead = nullptr;
+  unsigned* cqTail = nullptr;
+  unsigned cqMask = 0;
+  io_uring_cqe* cqes = nullptr;
+
+  ~Ring() {
+    if (sqes != MAP_FAILED) {
+      ::munmap(sqes, sqesSize);
+    }
+    if (cqMemory != MAP_FAILED && cqMemory != sqMemory) {
+      ::munmap(cqMemory, cqMemorySize);
+    }
+    if (sqMemory != MAP_FAILED) {
+      ::munmap(sqMemory, sqMemorySize);
+    }
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  // Returns 0 or an errno value.
+  int setup(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+      return errno;
+    }
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      return ENOSYS;
+    }
+
+    sqMemorySize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqMemorySize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+      sqMemorySize = cqMemorySize = std::max(sqMemorySize, cqMemorySize);
+    }
+    sqMemory = ::mmap(nullptr, sqMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQ_RING);
+    if (sqMemory == MAP_FAILED) {
+      return errno;
+    }
+    cqMemory = single ? sqMemory
+                      : ::mmap(nullptr, cqMemorySize, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cqMemory == MAP_FAILED) {
+      return errno;
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                              MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED) {
+      return errno;
+    }
+
+    char* sq = static_cast<char*>(sqMemory);
+    char* cq = static_cast<char*>(cqMemory);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return 0;
+  }
+
+  void registerBuffers(const std::vector<Buffer>& buffers, size_t size) {
+    std::vector<iovec> iov;
+    for (const Buffer& buffer : buffers) {
+      iov.push_back({buffer.data, size});
+    }
+    // Pinning can fail under a low RLIMIT_MEMLOCK; plain writes still work.
+    fixedBuffers = ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, iov.data(),
+                             static_cast<unsigned>(iov.size())) == 0;
+  }
+
+  // Requests are submitted one at a time as soon as they are prepared, and
+  // submit() takes back an entry the kernel did not consume, so the
+  // submission queue never holds more than one entry.
+  io_uring_sqe* prepare() {
+    unsigned tail = *sqTail;
+    io_uring_sqe* sqe = &sqes[tail & sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[tail & sqMask] = tail & sqMask;
+    return sqe;
+  }
+
+  // Returns 0 once the kernel has consumed the prepared entry, which then
+  // completes through the completion queue. Otherwise the entry is taken
+  // back out of the ring, so that no later io_uring_enter() submits it, and
+  // an errno value is returned; the request's buffer is free again.
+  int submit() {
+    unsigned tail = *sqTail + 1;
+    __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+    long n;
+    while ((n = ::syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0)) < 0 && errno == EINTR) {
+    }
+    int error = n < 0 ? errno : EAGAIN;
+    // Without SQPOLL the kernel only consumes entries inside io_uring_enter,
+    // so the head cannot move after this check.
+    if (__atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == tail) {
+      return 0;
+    }
+    __atomic_store_n(sqTail, tail - 1, __ATOMIC_RELEASE);
+    return error;
+  }
+
+  void waitForCompletion() {
+    while (::syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+           errno == EINTR) {
+    }
+  }
+};
+
+#else
+
+struct UringFileSink::Ring {};
+
+#endif  // HALCYON_LOG_HAS_IO_URING
+
+std::shared_ptr<Sink> UringFileSink::create(const std::string& path,
+                                            const UringFileSinkOptions& options) {
+  try {
+    return std::make_shared<UringFileSink>(path, options);
+  } catch (const std::system_error&) {
+    // io_uring is missing or refused (ENOSYS, EPERM under seccomp, ...). A
+    // file that cannot be opened makes the FileSink throw in turn.
+  }
+  FileSinkOptions fileOptions;
+  fileOptions.bufferSize = options.bufferSize;
+  fileOptions.maxBuffers = options.bufferCount;
+  return std::make_shared<FileSink>(path, fileOptions);
+}
+
+UringFileSink::UringFileSink(const std::string& path, const UringFileSinkOptions& options)
+    : options_(options), ring_(std::make_unique<Ring>()) {
+#if HALCYON_LOG_HAS_IO_URING
+  // A write and a sync per buffer can be in flight at once.
+  int error = ring_->setup(static_cast<unsigned>(options_.bufferCount * 2));
+  if (error != 0) {
+    throw std::system_error(error, std::generic_category(), "io_uring_setup");
+  }
+  // No O_APPEND: writes run concurrently in the kernel, so each one gets an
+  // explicit offset past the end of the previous one.
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+  struct stat st;
+  if (fd_ < 0 || ::fstat(fd_, &st) != 0) {
+    error = errno;
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    throw std::system_error(error, std::generic_category(), "open " + path);
+  }
+  offset_ = static_cast<uint64_t>(st.st_size);
+  syncedOffset_ = offset_;
+
+  memory_ = std::make_unique<char[]>(options_.bufferSize * options_.bufferCount);
+  buffers_.resize(options_.bufferCount);
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    buffers_[i].data = memory_.get() + i * options_.bufferSize;
+    free_.push_back(static_cast<uint32_t>(buffers_.size() - 1 - i));
+  }
+  ring_->registerBuffers(buffers_, options_.bufferSize);
+  nextBuffer();
+#else
+  (void)path;
+  throw std::system_error(ENOSYS, std::generic_category(), "io_uring");
+#endif
+}
+
+UringFileSink::~UringFileSink() {
+  if (fd_ >= 0) {
+    flush();
+    ::close(fd_);
+  }
+}
+
+void UringFileSink::write(std::string_view line) {
+  const char* data = line.data();
+  size_t size = line.size();
+  while (size != 0) {
+    Buffer& buffer = buffers_[current_];
+    size_t n = std::min(size, options_.bufferSize - buffer.size);
+    std::memcpy(buffer.data + buffer.size, data, n);
+    buffer.size += n;
+    data += n;
+    size -= n;
+    if (buffer.size == options_.bufferSize) {
+      submitCurrent();
+    }
+  }
+}
+
+void UringFileSink::flushAsync() {
+  submitCurrent();
+  // An idle sink has nothing to sync.
+  if (options_.dataSync && offset_ != syncedOffset_) {
+    submitSync();
+  }
+  reap(false);
+}
+
+void UringFileSink::flush() {
+  flushAsync();
+  while (inFlight_ != 0) {
+    reap(true);
+  }
+}
+
+void UringFileSink::submitCurrent() {
+  Buffer& buffer = buffers_[current_];
+  if (buffer.size == 0) {
+    return;
+  }
+  buffer.written = 0;
+  buffer.offset = offset_;
+  offset_ += buffer.size;
+  ++inFlight_;
+  submitWrite(current_);
+  nextBuffer();
+}
+
+#if HALCYON_LOG_HAS_IO_URING
+
+void UringFileSink::submitWrite(uint32_t index) {
+  const Buffer& buffer = buffers_[index];
+  io_uring_sqe* sqe = ring_->prepare();
+  sqe->opcode = ring_->fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+  sqe->fd = fd_;
+  sqe->addr = reinterpret_cast<uintptr_t>(buffer.data + buffer.written);
+  sqe->len = static_cast<uint32_t>(buffer.size - buffer.written);
+  sqe->off = buffer.offset + buffer.written;
+  sqe->buf_index = static_cast<uint16_t>(index);
+  sqe->user_data = index;
+  if (int error = ring_->submit(); error != 0) {
+    // submit() took the entry back, so the buffer can be reused at once.
+    report(error);
+    buffers_[index].size = 0;
+    free_.push_back(index);
+    --inFlight_;
+  }
+}
+
+void UringFileSink::submitSync() {
+  io_uring_sqe* sqe = ring_->prepare();
+  sqe->opcode = IORING_OP_FSYNC;
+  sqe->fd = fd_;
+  sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+  // Drain: start only after every write submitted before it has completed.
+  sqe->flags = IOSQE_IO_DRAIN;
+  sqe->user_data = kSyncTag;
+  ++inFlight_;
+  if (int error = ring_->submit(); error != 0) {
+    report(error);
+    --inFlight_;
+    return;
+  }
+  syncedOffset_ = offset_;
+}
+
+void UringFileSink::reap(bool wait) {
+  if (wait) {
+    ring_->waitForCompletion();
+  }
+  unsigned head = *ring_->cqHead;
+  unsigned tail = __atomic_load_n(ring_->cqTail, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    const io_uring_cqe& cqe = ring_->cqes[head & ring_->cqMask];
+    uint64_t tag = cqe.user_data;
+    int result = cqe.res;
+    __atomic_store_n(ring_->cqHead, head + 1, __ATOMIC_RELEASE);
+    --inFlight_;
+    if (tag == kSyncTag) {
+      if (result < 0) {
+        report(-result);
+      }
+      continue;
+    }
+
+    uint32_t index = static_cast<uint32_t>(tag);
+    Buffer& buffer = buffers_[index];
+    if (result == -EINTR || result == -EAGAIN) {
+      result = 0;
+    } else if (result < 0) {
+      report(-result);
+      result = static_cast<int>(buffer.size - buffer.written);
+    }
+    buffer.written += static_cast<size_t>(result);
+    if (buffer.written < buffer.size) {
+      // Short write: resubmit the rest at its offset.
+      ++inFlight_;
+      submitWrite(index);
+    } else {
+      buffer.size = 0;
+      free_.push_back(index);
+    }
+  }
+}
+
+#else
+
+void UringFileSink::submitWrite(uint32_t) {}
+void UringFileSink::submitSync() {}
+void UringFileSink::reap(bool) {}
+
+#endif  // HALCYON_LOG_HAS_IO_URING
+
+void UringFileSink::nextBuffer() {
+  reap(false);
+  while (free_.empty()) {
+    reap(true);
+  }
+  current_ = free_.back();
+  free_.pop_back();
+}
+
+void UringFileSink::report(int error) {
+  if (error != lastError_) {
+    lastError_ = error;
+    std::fprintf(stderr, "halcyon_log: io_uring write failed: %s\n", std::strerror(error));
+  }
+}
+
+}  // namespace halcyon::log
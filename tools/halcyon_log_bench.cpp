@@ -0,0 +1,414 @@
+// Measures producer latency and throughput of halcyon_log.
+//
+//   halcyon_log_bench [--records N] [--threads N] [--modes LIST] [--sinks LIST]
+//                     [--dir DIR] [--pin]
+//
+// Runs every combination of mode, sink and thread count (1, 2, 4, ... up to
+// --threads) in a fresh child process, since the backend is configured once
+// per process, and prints one JSON object per line: a header describing the
+// machine and run, then one result per combination.
+//
+// Modes:
+//   sync    the calling thread encodes, formats and writes each record
+//           itself, under a mutex; the baseline a synchronous logger pays
+//   async   LOGF_INFO through the backend to a text sink
+//   binary  LOGF_INFO through the backend to a binary sink
+//
+// Sinks:
+//   null    discards what it is given, after binary encoding in binary mode
+//   file    a file in --dir, /dev/shm by default so that the disk does not
+//           dominate; removed after the run
+//
+// Each result holds the per-call latency percentiles of the log statement
+// (TSC ticks converted to nanoseconds), the rate at which the producers got
+// their records in, and the rate at which the records were written out,
+// which for the asynchronous modes is the backend's drain rate.
+
+#include <pthread.h>
+#include <sched.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "halcyon/log/backend.h"
+#include "halcyon/log/binary_format.h"
+#include "halcyon/log/clock.h"
+#include "halcyon/log/formatter.h"
+#include "halcyon/log/logger.h"
+#include "halcyon/log/sink.h"
+
+extern char** environ;
+
+namespace {
+
+using namespace halcyon::log;
+using SteadyClock = std::chrono::steady_clock;
+
+constexpr int kWarmupRecords = 10000;
+
+struct Options {
+  long records = 200000;
+  int threads = 0;
+  std::string modes = "sync,async,binary";
+  std::string sinks = "null,file";
+  std::string dir = "/dev/shm";
+  bool pin = false;
+};
+
+std::vector<std::string> split(const std::string& list) {
+  std::vector<std::string> items;
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    if (end > start) {
+      items.push_back(list.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+  return items;
+}
+
+// Ticks of the latency clock: the TSC where there is one.
+uint64_t ticks() {
+#if HALCYON_LOG_HAS_TSC
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(SteadyClock::now().time_since_epoch().count());
+#endif
+}
+
+class NullSink : public Sink {
+ public:
+  void write(std::string_view line) override { (void)line; }
+  void flush() override {}
+};
+
+// Pays for the binary encoding, then discards the frame.
+class NullBinarySink : public Sink {
+ public:
+  NullBinarySink() { encoder_.writeHeader(frame_, 0); }
+
+  bool wantsText() const override { return false; }
+  void writeRecord(const Record& record) override {
+    frame_.clear();
+    encoder_.writeRecord(frame_, record);
+  }
+  void flush() override {}
+
+ private:
+  binary::Encoder encoder_;
+  std::string frame_;
+};
+
+// The statement every mode logs.
+#define BENCH_FORMAT "order {} filled: {} @ {} on {}"
+using BenchArgTypes = detail::ArgTypeList<long, int, double, std::string_view>;
+constexpr auto kBenchSegments =
+    detail::compileFormat<detail::countSegments(BENCH_FORMAT), BenchArgTypes>(BENCH_FORMAT);
+constinit CallSite gBenchSite{__FILE__,
+                              "halcyon_log_bench",
+                              __LINE__,
+                              Level::kInfo,
+                              BENCH_FORMAT,
+                              kBenchSegments.data(),
+                              static_cast<uint32_t>(kBenchSegments.size()),
+                              BenchArgTypes::kTypes.data(),
+                              static_cast<uint32_t>(BenchArgTypes::kTypes.size())};
+
+// Synchronous logging: what the backend does, done on the calling thread.
+class SyncLogger {
+ public:
+  explicit SyncLogger(std::shared_ptr<Sink> sink) : sink_(std::move(sink)) {}
+
+  void log(long id, int quantity, double price, std::string_view venue) {
+    thread_local std::string args;
+    detail::ArgEncoder<long, int, double, std::string_view> encoder;
+    args.resize(encoder.size(id, quantity, price, venue));
+    char* end = encoder.encode(args.data(), id, quantity, price, venue);
+
+    Record record;
+    record.timestamp = static_cast<int64_t>(detail::systemNanoseconds());
+    record.threadId = currentThreadId();
+    record.siteId = gBenchSite.id();
+    record.site = &gBenchSite;
+    record.args = std::string_view(args.data(), static_cast<size_t>(end - args.data()));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sink_->wantsText()) {
+      line_.clear();
+      formatter_.format(record, line_);
+      sink_->write(line_);
+    } else {
+      sink_->writeRecord(record);
+    }
+  }
+
+  void flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_->flush();
+  }
+
+ private:
+  std::shared_ptr<Sink> sink_;
+  std::mutex mutex_;
+  Formatter formatter_;
+  std::string line_;
+};
+
+void pinTo(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % static_cast<int>(std::thread::hardware_concurrency()), &set);
+  ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+}
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, double q) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto rank = static_cast<size_t>(q * static_cast<double>(sorted.size()));
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+// Runs one combination in this process and prints its result line.
+int runOne(const Options& options, const std::string& mode, const std::string& sinkName,
+           int threads) {
+  std::string path;
+  std::shared_ptr<Sink> sink;
+  bool binaryMode = mode == "binary";
+  if (sinkName == "null") {
+    sink = binaryMode ? std::shared_ptr<Sink>(std::make_shared<NullBinarySink>())
+                      : std::make_shared<NullSink>();
+  } else if (sinkName == "file") {
+    path = options.dir + "/halcyon_log_bench." + std::to_string(::getpid()) + ".log";
+    sink = binaryMode ? std::shared_ptr<Sink>(std::make_shared<BinaryFileSink>(path))
+                      : std::make_shared<FileSink>(path);
+  } else {
+    std::fprintf(stderr, "halcyon_log_bench: unknown sink %s\n", sinkName.c_str());
+    return 2;
+  }
+
+  std::unique_ptr<SyncLogger> syncLogger;
+  if (mode == "sync") {
+    syncLogger = std::make_unique<SyncLogger>(sink);
+  } else if (mode == "async" || binaryMode) {
+    Backend::instance().addSink(sink);
+    Backend::instance().start();
+  } else {
+    std::fprintf(stderr, "halcyon_log_bench: unknown mode %s\n", mode.c_str());
+    return 2;
+  }
+
+  auto logOne = [&](long i) {
+    if (syncLogger) {
+      syncLogger->log(i, 100, 123.45, "XNAS");
+    } else {
+      LOGF_INFO(BENCH_FORMAT, i, 100, 123.45, std::string_view("XNAS"));
+    }
+  };
+  auto drain = [&] {
+    if (syncLogger) {
+      syncLogger->flush();
+    } else {
+      Backend::instance().flush();
+    }
+  };
+
+  std::vector<std::vector<uint64_t>> latencies(static_cast<size_t>(threads));
+  std::vector<SteadyClock::time_point> finished(static_cast<size_t>(threads));
+  std::latch ready(threads + 1);
+  std::latch go(1);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < threads; ++t) {
+    producers.emplace_back([&, t] {
+      if (options.pin) {
+        pinTo(t);
+      }
+      // Warm up the thread's context, its ring and the caches.
+      for (long i = 0; i < kWarmupRecords; ++i) {
+        logOne(i);
+      }
+      auto& samples = latencies[static_cast<size_t>(t)];
+      samples.resize(static_cast<size_t>(options.records));
+      ready.count_down();
+      go.wait();
+      for (long i = 0; i < options.records; ++i) {
+        uint64_t start = ticks();
+        logOne(i);
+        samples[static_cast<size_t>(i)] = ticks() - start;
+      }
+      finished[static_cast<size_t>(t)] = SteadyClock::now();
+    });
+  }
+  ready.arrive_and_wait();
+  drain();
+  uint64_t startTicks = ticks();
+  auto start = SteadyClock::now();
+  go.count_down();
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  auto enqueued = *std::max_element(finished.begin(), finished.end());
+  drain();
+  auto written = SteadyClock::now();
+  uint64_t endTicks = ticks();
+
+  double elapsedNs = std::chrono::duration<double, std::nano>(written - start).count();
+  double nsPerTick = elapsedNs / static_cast<double>(endTicks - startTicks);
+  std::vector<uint64_t> all;
+  all.reserve(static_cast<size_t>(options.records) * static_cast<size_t>(threads));
+  for (const auto& samples : latencies) {
+    all.insert(all.end(), samples.begin(), samples.end());
+  }
+  std::sort(all.begin(), all.end());
+  auto ns = [&](uint64_t t) { return static_cast<uint64_t>(static_cast<double>(t) * nsPerTick); };
+
+  double total = static_cast<double>(options.records) * threads;
+  double enqueueSeconds = std::chrono::duration<double>(enqueued - start).count();
+  double writeSeconds = std::chrono::duration<double>(written - start).count();
+  uint64_t dropped = 0;
+  size_t highWater = 0;
+  if (!syncLogger) {
+    LogStats stats = Backend::instance().stats();
+    for (uint64_t count : stats.dropped) {
+      dropped += count;
+    }
+    highWater = stats.queueHighWater;
+  }
+  std::printf(
+      "{\"mode\":\"%s\",\"sink\":\"%s\",\"threads\":%d,\"records\":%.0f,"
+      "\"latency_ns\":{\"p50\":%" PRIu64 ",\"p99\":%" PRIu64 ",\"p999\":%" PRIu64
+      ",\"max\":%" PRIu64 "},\"enqueue_per_sec\":%.0f,\"write_per_sec\":%.0f,"
+      "\"dropped\":%" PRIu64 ",\"queue_high_water\":%zu}\n",
+      mode.c_str(), sinkName.c_str(), threads, total, ns(percentile(all, 0.5)),
+      ns(percentile(all, 0.99)), ns(percentile(all, 0.999)), ns(all.empty() ? 0 : all.back()),
+      total / enqueueSeconds, total / writeSeconds, dropped, highWater);
+  std::fflush(stdout);
+
+  if (!syncLogger) {
+    Backend::instance().stop();
+  }
+  if (!path.empty()) {
+    ::unlink(path.c_str());
+  }
+  return 0;
+}
+
+int spawn(const std::vector<std::string>& args) {
+  std::vector<char*> argv;
+  for (const std::string& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  pid_t pid;
+  int error = ::posix_spawn(&pid, "/proc/self/exe", nullptr, nullptr, argv.data(), environ);
+  if (error != 0) {
+    std::fprintf(stderr, "halcyon_log_bench: cannot spawn: %s\n", std::strerror(error));
+    return 1;
+  }
+  int status;
+  while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+void usage(const char* argv0) {
+  std::fprintf(stderr,
+               "usage: %s [--records N] [--threads N] [--modes sync,async,binary]\n"
+               "          [--sinks null,file] [--dir DIR] [--pin]\n",
+               argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  std::string runMode;
+  std::string runSink;
+  int runThreads = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--pin") {
+      options.pin = true;
+    } else if (arg == "--records" && hasValue) {
+      options.records = std::atol(argv[++i]);
+    } else if (arg == "--threads" && hasValue) {
+      options.threads = std::atoi(argv[++i]);
+    } else if (arg == "--modes" && hasValue) {
+      options.modes = argv[++i];
+    } else if (arg == "--sinks" && hasValue) {
+      options.sinks = argv[++i];
+    } else if (arg == "--dir" && hasValue) {
+      options.dir = argv[++i];
+    } else if (arg == "--run" && i + 3 < argc) {
+      // Internal: one combination, in a child process.
+      runMode = argv[++i];
+      runSink = argv[++i];
+      runThreads = std::atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (options.records <= 0) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (!runMode.empty()) {
+    return runOne(options, runMode, runSink, std::max(runThreads, 1));
+  }
+
+  int cpus = static_cast<int>(std::thread::hardware_concurrency());
+  int maxThreads = options.threads > 0 ? options.threads : std::max(cpus, 1);
+  struct stat st;
+  if (::stat(options.dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+    std::fprintf(stderr, "halcyon_log_bench: %s is not a directory\n", options.dir.c_str());
+    return 2;
+  }
+
+  std::printf(
+      "{\"bench\":\"halcyon_log\",\"version\":\"%s\",\"cpus\":%d,\"tsc\":%s,"
+      "\"records_per_thread\":%ld,\"warmup_per_thread\":%d,\"dir\":\"%s\",\"pinned\":%s}\n",
+      HALCYON_LOG_VERSION, cpus, HALCYON_LOG_HAS_TSC && hasInvariantTsc() ? "true" : "false",
+      options.records, kWarmupRecords, options.dir.c_str(), options.pin ? "true" : "false");
+  std::fflush(stdout);
+
+  int status = 0;
+  for (const std::string& mode : split(options.modes)) {
+    for (const std::string& sink : split(options.sinks)) {
+      for (int threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        std::vector<std::string> args = {argv[0], "--records", std::to_string(options.records),
+                                         "--dir", options.dir, "--run", mode, sink,
+                                         std::to_string(threads)};
+        if (options.pin) {
+          args.push_back("--pin");
+        }
+        status = std::max(status, spawn(args));
+        if (threads == maxThreads) {
+          break;
+        }
+      }
+    }
+  }
+  return status;
+}
@@ -0,0 +1,95 @@
+// Renders a binary log written by BinaryFileSink as text.
+//
+//   halcyon_log_decode [--layout text|json|logfmt] FILE
+//
+// Output goes to stdout, in the text layout unless told otherwise.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "halcyon/log/binary_format.h"
+#include "halcyon/log/formatter.h"
+
+namespace {
+
+int decode(const char* path, halcyon::log::Layout layout) {
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    std::fprintf(stderr, "halcyon_log_decode: %s: %s\n", path, std::strerror(errno));
+    return 1;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    std::fprintf(stderr, "halcyon_log_decode: %s: %s\n", path, std::strerror(errno));
+    ::close(fd);
+    return 1;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  void* data = size ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    std::fprintf(stderr, "halcyon_log_decode: %s: %s\n", path, std::strerror(errno));
+    return 1;
+  }
+  ::madvise(data, size, MADV_SEQUENTIAL);
+
+  halcyon::log::binary::Decoder decoder(std::string_view(static_cast<const char*>(data), size));
+  int status = 0;
+  if (!decoder.readHeader()) {
+    std::fprintf(stderr, "halcyon_log_decode: %s: %s\n", path, decoder.error().c_str());
+    status = 1;
+  } else {
+    halcyon::log::Formatter formatter(layout);
+    halcyon::log::Record record;
+    std::string out;
+    using Status = halcyon::log::binary::Decoder::Status;
+    Status result;
+    while ((result = decoder.next(record)) == Status::kRecord) {
+      formatter.format(record, out);
+      if (out.size() >= 64 * 1024) {
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        out.clear();
+      }
+    }
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    if (result == Status::kError) {
+      // A file cut short by a crash still decodes up to the damaged frame.
+      std::fprintf(stderr, "halcyon_log_decode: %s: %s\n", path, decoder.error().c_str());
+      status = 1;
+    }
+  }
+  if (data != nullptr) {
+    ::munmap(data, size);
+  }
+  return status;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using halcyon::log::Layout;
+  Layout layout = Layout::kText;
+  int i = 1;
+  if (argc == 4 && std::strcmp(argv[1], "--layout") == 0) {
+    if (std::strcmp(argv[2], "json") == 0) {
+      layout = Layout::kJson;
+    } else if (std::strcmp(argv[2], "logfmt") == 0) {
+      layout = Layout::kLogfmt;
+    } else if (std::strcmp(argv[2], "text") != 0) {
+      argc = 0;
+    }
+    i = 3;
+  }
+  if (argc != i + 1) {
+    std::fprintf(stderr, "usage: %s [--layout text|json|logfmt] FILE\n", argv[0]);
+    return 2;
+  }
+  return decode(argv[i], layout);
+}